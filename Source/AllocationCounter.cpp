@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.cpp
+
+  ==============================================================================
+*/
+
+#include "AllocationCounter.h"
+
+#include <cstdlib>
+#include <new>
+
+#if defined (_WIN32)
+ #include <malloc.h>
+#endif
+
+namespace
+{
+   #if defined (__GLIBC__)
+    // static TLS: the first touch of a dynamic one would call malloc from inside malloc
+    __attribute__((tls_model("initial-exec")))
+   #endif
+    thread_local uint64_t numAllocations = 0;
+}
+
+uint64_t AllocationCounter::getNumAllocations() noexcept
+{
+    return numAllocations;
+}
+
+#if LAUTEQ_COUNT_ALLOCATIONS
+
+#if defined (__GLIBC__)
+// juce::HeapBlock (and so AudioBuffer, Path, String) goes straight to malloc, so on glibc
+// malloc itself is counted too. free stays glibc's, it gets the same blocks.
+extern "C"
+{
+    void* __libc_malloc(size_t);
+    void* __libc_calloc(size_t, size_t);
+    void* __libc_realloc(void*, size_t);
+
+    void* malloc(size_t size) noexcept              { ++numAllocations; return __libc_malloc(size); }
+    void* calloc(size_t count, size_t size) noexcept { ++numAllocations; return __libc_calloc(count, size); }
+    void* realloc(void* p, size_t size) noexcept    { ++numAllocations; return __libc_realloc(p, size); }
+}
+
+static void* allocate(size_t size)
+{
+    // malloc above has counted it already
+    if( auto* p = malloc(size == 0 ? 1 : size) )
+        return p;
+
+    throw std::bad_alloc();
+}
+#else
+// elsewhere only operator new is seen, blocks juce gets from malloc are not counted
+static void* allocate(size_t size)
+{
+    ++numAllocations;
+
+    if( auto* p = std::malloc(size == 0 ? 1 : size) )
+        return p;
+
+    throw std::bad_alloc();
+}
+#endif
+
+void* operator new(size_t size)                         { return allocate(size); }
+void* operator new[](size_t size)                       { return allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept                  { std::free(p); }
+void operator delete[](void* p) noexcept                { std::free(p); }
+void operator delete(void* p, size_t) noexcept          { std::free(p); }
+void operator delete[](void* p, size_t) noexcept        { std::free(p); }
+
+// Over-aligned types (alignas beyond what new guarantees, e.g. SIMD blocks) come here.
+// No libc allocates them through malloc, so they are counted on every platform.
+static void* allocateAligned(size_t size, std::align_val_t alignment)
+{
+    ++numAllocations;
+
+    // the alignment is a power of two above the default, so also a multiple of a pointer
+    auto align = static_cast<size_t>(alignment);
+    size = size == 0 ? 1 : size;
+
+   #if defined (_WIN32)
+    if( auto* p = _aligned_malloc(size, align) )
+        return p;
+   #else
+    void* p = nullptr;
+    if( posix_memalign(&p, align, size) == 0 )
+        return p;
+   #endif
+
+    throw std::bad_alloc();
+}
+
+static void freeAligned(void* p) noexcept
+{
+   #if defined (_WIN32)
+    _aligned_free(p);
+   #else
+    std::free(p);
+   #endif
+}
+
+void* operator new(size_t size, std::align_val_t alignment)     { return allocateAligned(size, alignment); }
+void* operator new[](size_t size, std::align_val_t alignment)   { return allocateAligned(size, alignment); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocateAligned(size, alignment); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p, std::align_val_t) noexcept            { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept          { freeAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept    { freeAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept  { freeAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept     { freeAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept   { freeAligned(p); }
+
+#endif
@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    AllocationCounter.h
+
+    Counts the heap allocations a thread makes, to check that the analyzer
+    really draws its frames without any.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Off by default: counting replaces the global operator new (and malloc on glibc)
+// for the whole process. Build with LAUTEQ_COUNT_ALLOCATIONS=1 to turn it on, and use
+// the Standalone: in a plugin loaded by a host the host's allocator is found first.
+#ifndef LAUTEQ_COUNT_ALLOCATIONS
+ #define LAUTEQ_COUNT_ALLOCATIONS 0
+#endif
+
+namespace AllocationCounter
+{
+    constexpr bool isEnabled() { return LAUTEQ_COUNT_ALLOCATIONS != 0; }
+
+    // allocations made by the calling thread since it started, always 0 when disabled
+    uint64_t getNumAllocations() noexcept;
+}
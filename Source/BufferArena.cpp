@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    BufferArena.cpp
+
+  ==============================================================================
+*/
+
+#include "BufferArena.h"
+
+void BufferArena::prepare(const ArenaLayout& layout)
+{
+    auto numBytes = layout.getNumBytes();
+
+    if( numBytes > size )
+    {
+        // the one before the previous block goes now (the move swaps it into 'block')
+        previousBlock = std::move(block);
+        previousNumBytesAllocated = numBytesAllocated;
+
+        // HeapBlock only promises malloc's alignment, the slack covers the rest
+        numBytesAllocated = numBytes + ArenaLayout::alignment;
+        block.allocate(numBytesAllocated, false);
+
+        auto address = reinterpret_cast<uintptr_t>(block.get());
+        auto aligned = (address + ArenaLayout::alignment - 1) & ~(uintptr_t) (ArenaLayout::alignment - 1);
+        data = block.get() + (aligned - address);
+
+        size = numBytes;
+        peakBytes = juce::jmax(peakBytes, numBytesAllocated + previousNumBytesAllocated);
+        ++numAllocations;
+    }
+
+    if( data != nullptr )
+        std::memset(data, 0, size);
+}
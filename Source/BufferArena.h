@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    BufferArena.h
+
+    One block of memory for an instance's sample buffers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/*
+ The buffers an instance needs for a given sample rate and block size, first described
+ as a layout, then placed in one contiguous block. Every region starts on a cache line
+ of its own, so no two buffers share one, and the SIMD kernels always get aligned data.
+
+ prepare only reallocates when the layout needs more than the block has, a smaller or
+ equal layout reuses it. The block that was replaced stays alive until the next growth:
+ the editor may still be copying out of an analyzer fifo while prepareToPlay runs.
+ */
+struct ArenaLayout
+{
+    static constexpr size_t alignment = 64;
+
+    // returns the offset of a new region for numFloats floats
+    size_t addFloats(size_t numFloats) noexcept
+    {
+        auto offset = numBytes;
+        numBytes += (numFloats * sizeof(float) + alignment - 1) & ~(alignment - 1);
+        return offset;
+    }
+
+    size_t getNumBytes() const { return numBytes; }
+
+private:
+    size_t numBytes = 0;
+};
+
+class BufferArena
+{
+public:
+    BufferArena() = default;
+
+    // makes room for 'layout' and clears it, allocates only if it doesn't fit
+    void prepare(const ArenaLayout& layout);
+
+    float* getFloats(size_t offset) const noexcept
+    {
+        jassert( offset < size );
+        return reinterpret_cast<float*>(data + offset);
+    }
+
+    size_t getSize() const { return size; }
+    size_t getPeakBytes() const { return peakBytes; }
+    int getNumAllocations() const { return numAllocations; }
+
+private:
+    juce::HeapBlock<char> block, previousBlock;
+    char* data = nullptr;       // block, moved up to the next cache line
+    size_t size = 0;
+
+    size_t numBytesAllocated = 0, previousNumBytesAllocated = 0;
+    size_t peakBytes = 0;       // both blocks together
+    int numAllocations = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BufferArena)
+};
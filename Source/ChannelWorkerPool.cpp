@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "ChannelWorkerPool.h"
+#include <thread>
+
+class ChannelWorkerPool::Worker : public juce::Thread
+{
+public:
+    Worker(ChannelWorkerPool& poolToUse, int index)
+        : juce::Thread("EQ Worker " + juce::String(index)), pool(poolToUse) {}
+
+    void run() override
+    {
+        auto seen = pool.generation.load(std::memory_order_acquire);
+        auto lastWork = juce::Time::getMillisecondCounterHiRes();
+
+        while( ! threadShouldExit() )
+        {
+            auto current = pool.generation.load(std::memory_order_acquire);
+
+            if( current != seen )
+            {
+                seen = current;
+                pool.workOnTasks();
+                lastWork = juce::Time::getMillisecondCounterHiRes();
+                continue;
+            }
+
+            if( juce::Time::getMillisecondCounterHiRes() - lastWork < spinMilliseconds )
+            {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // Either this sees the new generation or the caller sees the flag and signals,
+            // both are sequentially consistent. A signal that comes early isn't lost either.
+            sleeping.store(true);
+            if( pool.generation.load() == seen )
+                wakeUp.wait(-1);
+            sleeping.store(false);
+
+            lastWork = juce::Time::getMillisecondCounterHiRes();
+        }
+    }
+
+    void wake()
+    {
+        if( sleeping.load() )
+            wakeUp.signal();
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(1000);
+    }
+
+private:
+    ChannelWorkerPool& pool;
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> sleeping { false };
+};
+
+ChannelWorkerPool::ChannelWorkerPool(int numWorkersToUse)
+    : numWorkers(juce::jlimit(0, maxWorkers, numWorkersToUse))
+{
+}
+
+ChannelWorkerPool::~ChannelWorkerPool()
+{
+    for( auto* worker : workers )
+        worker->stop();
+}
+
+int ChannelWorkerPool::getDefaultNumWorkers()
+{
+    return juce::jlimit(0, maxWorkers, juce::SystemStats::getNumCpus() - 1);
+}
+
+bool ChannelWorkerPool::tryRunTasks(int numTasksToRun, TaskFunction functionToRun, void* contextToUse) noexcept
+{
+    if( numTasksToRun <= 0 )
+        return true;
+
+    if( numWorkers == 0 || numTasksToRun == 1 || busy.exchange(true, std::memory_order_acquire) )
+        return false;
+
+    // the first call starts the threads, that's the only time the pool allocates
+    if( workers.isEmpty() )
+        for( int i = 0; i < numWorkers; ++i )
+            workers.add(new Worker(*this, i))->startThread();
+
+    // everything a worker needs is written before the counter that hands out the tasks
+    function = functionToRun;
+    context = contextToUse;
+    numTasksDone.store(0, std::memory_order_relaxed);
+    nextTask.store((uint64_t) numTasksToRun << 32, std::memory_order_release);
+    generation.fetch_add(1);
+
+    // the calling thread takes a task itself, a worker that is awake anyway may join in
+    for( int i = 0; i < juce::jmin(numWorkers, numTasksToRun - 1); ++i )
+        workers.getUnchecked(i)->wake();
+
+    workOnTasks();
+
+    while( numTasksDone.load(std::memory_order_acquire) < numTasksToRun )
+        std::this_thread::yield();
+
+    busy.store(false, std::memory_order_release);
+    return true;
+}
+
+void ChannelWorkerPool::workOnTasks() noexcept
+{
+    for( ;; )
+    {
+        auto ticket = nextTask.fetch_add(1, std::memory_order_acq_rel);
+        auto numTasks = (int) (ticket >> 32);
+        auto index = (int) (ticket & 0xffffffffu);
+
+        if( index >= numTasks )
+            return;
+
+        function(context, index);
+        numTasksDone.fetch_add(1, std::memory_order_release);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+  ==============================================================================
+
+    ChannelWorkerPool.h
+
+    Fork/join over a few persistent threads, for offline renders of wide buses.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+//==============================================================================
+/*
+ A set of worker threads that run numbered tasks for one caller at a time, shared by
+ every instance in the process. Hold it through a juce::SharedResourcePointer, so
+ however many tracks render at once there are never more workers than the pool has,
+ at most maxWorkers and one less than there are cores.
+
+ tryRun() hands the task indices out through a single atomic counter, works on them
+ itself as well, and returns once every task is done. If another instance is using the
+ pool it returns false straight away and the caller does the work itself, which is
+ what a busy machine wants anyway. Nothing is allocated or locked per call.
+
+ The threads are only started by the first call, so a session that never renders
+ offline never has them. After a call the workers keep spinning for spinMilliseconds
+ before they go to sleep, so blocks that follow each other closely, like in an offline
+ render, find them awake. Waking a sleeping worker costs a few microseconds, which is
+ why the processor only uses the pool while rendering offline, and only for blocks with
+ enough work in them.
+
+ The counter carries the call's number of tasks in its high half. A worker that comes
+ late from the previous call draws an index at or past that call's count and stops, so
+ no task ever runs twice.
+ */
+class ChannelWorkerPool
+{
+public:
+    static constexpr double spinMilliseconds = 0.5;
+    static constexpr int maxWorkers = 7;
+
+    // the default is what SharedResourcePointer uses, one worker less than there are cores
+    explicit ChannelWorkerPool(int numWorkersToUse = getDefaultNumWorkers());
+    ~ChannelWorkerPool();
+
+    static int getDefaultNumWorkers();
+    int getNumWorkers() const { return numWorkers; }
+
+    // Calls task(index) for every index below numTasks, on the workers and the calling
+    // thread. False if the pool is busy with another caller, nothing has run then.
+    template <typename Task>
+    bool tryRun(int numTasks, Task& task) noexcept
+    {
+        return tryRunTasks(numTasks, [](void* context, int index) { (*static_cast<Task*>(context))(index); }, &task);
+    }
+
+private:
+    using TaskFunction = void (*)(void*, int);
+
+    class Worker;
+
+    bool tryRunTasks(int numTasksToRun, TaskFunction functionToRun, void* contextToUse) noexcept;
+    void workOnTasks() noexcept;
+
+    const int numWorkers;
+    juce::OwnedArray<Worker> workers;           // started by the first caller, under busy
+    std::atomic<bool> busy { false };
+
+    std::atomic<uint64_t> nextTask { 0 };       // numTasks << 32 | next index
+    std::atomic<uint32_t> generation { 0 };     // one up per call, what the workers watch
+    std::atomic<int> numTasksDone { 0 };
+
+    TaskFunction function = nullptr;
+    void* context = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ChannelWorkerPool)
+};
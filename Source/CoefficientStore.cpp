@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    CoefficientStore.cpp
+
+  ==============================================================================
+*/
+
+#include "CoefficientStore.h"
+#include <cstring>
+
+CoefficientStore::CoefficientStore()
+    : entries(new Entry[(size_t) (numSets * numWays)]),
+      nextVictim(new std::atomic<uint32_t>[(size_t) numSets])
+{
+    for( int i = 0; i < numSets; ++i )
+        nextVictim[(size_t) i].store(0);
+}
+
+CoefficientStore::Key CoefficientStore::makeKey(const BandSettings& settings, double sampleRate) noexcept
+{
+    // whatever a band type ignores stays zero, so e.g. every 80 Hz 24 dB low cut is one entry
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+
+    key.type = (int32_t) settings.type;
+    key.frequency = settings.frequency;
+    key.sampleRate = sampleRate;
+
+    switch( settings.type )
+    {
+        case PeakBand:
+        case LowShelfBand:
+        case HighShelfBand:
+            key.gainInDecibels = settings.gainInDecibels;
+            key.quality = settings.quality;
+            break;
+        case NotchBand:
+        case BandPassBand:
+            key.quality = settings.quality;
+            break;
+        case LowCutBand:
+        case HighCutBand:
+            key.order = settings.order;
+            break;
+    }
+
+    return key;
+}
+
+uint32_t CoefficientStore::hash(const Key& key) noexcept
+{
+    // the key as four 64 bit words, multiply-xorshift mixed
+    uint64_t words[sizeof(Key) / sizeof(uint64_t)];
+    std::memcpy(words, &key, sizeof(Key));
+
+    uint64_t h = 0x9e3779b97f4a7c15ull;
+    for( auto word : words )
+    {
+        h = (h ^ word) * 0xff51afd7ed558ccdull;
+        h ^= h >> 32;
+    }
+
+    return (uint32_t) h;
+}
+
+bool CoefficientStore::lookup(const BandSettings& settings, double sampleRate, BandCoefficients& result) noexcept
+{
+    auto key = makeKey(settings, sampleRate);
+    auto set = (int) (hash(key) % (uint32_t) numSets);
+
+    for( int way = 0; way < numWays; ++way )
+    {
+        auto& entry = entries[(size_t) (set * numWays + way)];
+
+        auto before = entry.sequence.load(std::memory_order_acquire);
+        if( before == 0 || (before & 1) != 0 )
+            continue;
+
+        if( std::memcmp(&entry.key, &key, sizeof(Key)) != 0 )
+            continue;
+
+        result = entry.coefficients;
+
+        // a writer got in between, the copy may be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if( entry.sequence.load(std::memory_order_relaxed) != before )
+            continue;
+
+        numHits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    numMisses.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+void CoefficientStore::insert(const BandSettings& settings, double sampleRate, const BandCoefficients& coefficients) noexcept
+{
+    auto key = makeKey(settings, sampleRate);
+    auto set = (int) (hash(key) % (uint32_t) numSets);
+
+    // the same inputs give the same design, so a key that's already there stays as it is.
+    // Otherwise an empty way if there is one, and the ways take turns when the set is full
+    auto way = -1;
+    for( int i = 0; i < numWays; ++i )
+    {
+        auto& entry = entries[(size_t) (set * numWays + i)];
+        auto before = entry.sequence.load(std::memory_order_acquire);
+
+        if( before == 0 )
+        {
+            if( way < 0 )
+                way = i;
+            continue;
+        }
+
+        if( (before & 1) == 0 && std::memcmp(&entry.key, &key, sizeof(Key)) == 0 )
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if( entry.sequence.load(std::memory_order_relaxed) == before )
+                return;
+        }
+    }
+
+    if( way < 0 )
+        way = (int) (nextVictim[(size_t) set].fetch_add(1, std::memory_order_relaxed) % (uint32_t) numWays);
+
+    auto& entry = entries[(size_t) (set * numWays + way)];
+
+    auto sequence = entry.sequence.load(std::memory_order_relaxed);
+    if( (sequence & 1) != 0 || ! entry.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire) )
+        return;
+
+    std::atomic_thread_fence(std::memory_order_release);
+
+    entry.key = key;
+    entry.coefficients = coefficients;
+
+    entry.sequence.store(sequence + 2, std::memory_order_release);
+}
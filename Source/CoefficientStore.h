@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    CoefficientStore.h
+
+    Process-wide design cache: band coefficients looked up instead of designed.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQEngine.h"
+#include <atomic>
+
+//==============================================================================
+/*
+ Band coefficients keyed by everything that goes into their design: type, frequency,
+ gain, Q, order and sample rate. A whole session of instances with the same low cut
+ designs it once, and the second lane of a linked engine never designs at all.
+
+ This saves design work, not memory: every engine still copies what it gets into its
+ own packed coefficient arrays, which it reads per sample, and the store is one more
+ fixed table on top of those.
+
+ Hold it through a juce::SharedResourcePointer<CoefficientStore>: the store itself is
+ reference counted and lives as long as any instance does.
+
+ The table has a fixed size and is allocated once, lookups and inserts are lock-free
+ and never allocate, so both are fine on the audio thread. Every entry is guarded by a
+ sequence number (a seqlock): a reader copies the entry and only takes it if the
+ sequence did not move meanwhile, a writer that finds the entry busy simply skips the
+ insert. A key that is already published isn't inserted again, and a published entry
+ is never changed in place, it can only be replaced as a whole by a newer design of
+ the same set, which keeps parameter sweeps from filling the table with stale designs.
+ Two threads inserting the same miss at once can still end up in two ways, which only
+ costs a way until one of them is replaced.
+ */
+class CoefficientStore
+{
+public:
+    static constexpr int numSets = 256;
+    static constexpr int numWays = 4;
+
+    struct BandCoefficients
+    {
+        int numSections = 0;
+        float b0[EQDesign::maxSectionsPerBand] {}, b1[EQDesign::maxSectionsPerBand] {}, b2[EQDesign::maxSectionsPerBand] {};
+        float a1[EQDesign::maxSectionsPerBand] {}, a2[EQDesign::maxSectionsPerBand] {};
+        double peakCosOmega = 0, peakAlpha = 0;
+    };
+
+    CoefficientStore();
+
+    bool lookup(const BandSettings& settings, double sampleRate, BandCoefficients& result) noexcept;
+    void insert(const BandSettings& settings, double sampleRate, const BandCoefficients& coefficients) noexcept;
+
+    int64_t getNumHits() const { return numHits.load(std::memory_order_relaxed); }
+    int64_t getNumMisses() const { return numMisses.load(std::memory_order_relaxed); }
+
+private:
+    // no implicit padding, so two keys compare with memcmp and hash as plain words
+    struct Key
+    {
+        int32_t type;
+        float frequency, gainInDecibels, quality;
+        int32_t order, unused;
+        double sampleRate;
+    };
+
+    static_assert( sizeof(Key) == 32, "Key must not have padding" );
+
+    static Key makeKey(const BandSettings& settings, double sampleRate) noexcept;
+    static uint32_t hash(const Key& key) noexcept;
+
+    struct Entry
+    {
+        std::atomic<uint32_t> sequence { 0 };       // 0 empty, odd while written
+        Key key {};
+        BandCoefficients coefficients;
+    };
+
+    std::unique_ptr<Entry[]> entries;
+    std::unique_ptr<std::atomic<uint32_t>[]> nextVictim;
+
+    std::atomic<int64_t> numHits { 0 }, numMisses { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CoefficientStore)
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    DynamicEQ.cpp
+
+  ==============================================================================
+*/
+
+#include "DynamicEQ.h"
+
+void DynamicEQ::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+
+    // force the detector and the coefficients to follow the new rate
+    detectorFrequency = 0;
+    attackCoefficient = smoothingCoefficient(settings.attackMs, controlInterval, sampleRate);
+    releaseCoefficient = smoothingCoefficient(settings.releaseMs, controlInterval, sampleRate);
+
+    reset();
+}
+
+void DynamicEQ::reset() noexcept
+{
+    detector.reset();
+    intervalPosition = 0;
+    intervalPeak = 0;
+    envelopeInDecibels = -100.f;
+    gainReduction = 0;
+}
+
+void DynamicEQ::setSettings(const DynamicSettings& newSettings) noexcept
+{
+    if( newSettings.attackMs != settings.attackMs )
+        attackCoefficient = smoothingCoefficient(newSettings.attackMs, controlInterval, sampleRate);
+
+    if( newSettings.releaseMs != settings.releaseMs )
+        releaseCoefficient = smoothingCoefficient(newSettings.releaseMs, controlInterval, sampleRate);
+
+    settings = newSettings;
+}
+
+void DynamicEQ::setDetectorBand(float frequency, float quality) noexcept
+{
+    if( frequency == detectorFrequency && quality == detectorQuality )
+        return;
+
+    BandSettings band;
+    band.type = BandPassBand;
+    band.frequency = frequency;
+    band.quality = quality;
+    detector.setBand(0, band, sampleRate);
+
+    detectorFrequency = frequency;
+    detectorQuality = quality;
+}
+
+float DynamicEQ::smoothingCoefficient(float timeMs, int numSamples, double sampleRate) noexcept
+{
+    if( sampleRate <= 0 || timeMs <= 0 )
+        return 0;
+
+    // one-pole smoothing, evaluated once every numSamples
+    return (float) std::exp(-numSamples / (timeMs * 0.001 * sampleRate));
+}
+
+float DynamicEQ::process(const float* const* detectorChannels, int numChannels, int numSamples) noexcept
+{
+    jassert( numSamples <= getNumSamplesUntilUpdate() );
+    numSamples = juce::jmin(numSamples, getNumSamplesUntilUpdate());
+
+    if( numSamples <= 0 || numChannels <= 0 )
+        return gainReduction;
+
+    // mono detector signal
+    auto* data = scratch.data();
+
+    if( numChannels > 1 )
+    {
+        for( int i = 0; i < numSamples; ++i )
+            data[i] = 0.5f * (detectorChannels[0][i] + detectorChannels[1][i]);
+    }
+    else
+    {
+        std::copy(detectorChannels[0], detectorChannels[0] + numSamples, data);
+    }
+
+    detector.process(&data, 1, numSamples);
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+    intervalPeak = juce::jmax(intervalPeak, -range.getStart(), range.getEnd());
+
+    intervalPosition += numSamples;
+    if( intervalPosition < controlInterval )
+        return gainReduction;
+
+    // a complete interval, whatever pieces it came in
+    auto levelInDecibels = juce::Decibels::gainToDecibels(intervalPeak, -100.f);
+    intervalPosition = 0;
+    intervalPeak = 0;
+
+    // peak envelope in dB, attack when rising, release when falling
+    auto coefficient = levelInDecibels > envelopeInDecibels ? attackCoefficient : releaseCoefficient;
+    envelopeInDecibels = levelInDecibels + coefficient * (envelopeInDecibels - levelInDecibels);
+
+    auto overshoot = envelopeInDecibels - settings.thresholdInDecibels;
+    gainReduction = overshoot > 0 ? overshoot * (1.f - 1.f / juce::jmax(1.f, settings.ratio)) : 0.f;
+
+    return gainReduction;
+}
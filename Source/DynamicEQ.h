@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    DynamicEQ.h
+
+    Level detector and gain computer for the dynamic peak band.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "EQEngine.h"
+
+struct DynamicSettings
+{
+    bool enabled = false;
+    bool useSidechain = false;
+    float thresholdInDecibels = -24.f;
+    float ratio = 2.f;
+    float attackMs = 10.f;
+    float releaseMs = 150.f;
+};
+
+//==============================================================================
+/*
+ Downward compression of one peak band.
+
+ The detector listens to the band itself: the input (or the sidechain) goes through a
+ band-pass at the band's frequency and Q, run by its own small EQEngine. Level and
+ envelope are only evaluated once per control interval, the caller then moves the
+ band's gain with EQEngine::setPeakGain, which skips the full redesign.
+
+ The intervals are a fixed grid over the stream, not over the blocks: an interval can
+ arrive in any number of pieces and still counts as one, so a host sending 8 samples
+ at a time gets the same gain curve as one sending 512.
+ */
+class DynamicEQ
+{
+public:
+    // samples between two gain updates
+    static constexpr int controlInterval = 32;
+
+    void prepare(double newSampleRate);
+    void reset() noexcept;
+
+    // cheap when nothing changed, fine to call every block
+    void setSettings(const DynamicSettings& newSettings) noexcept;
+    void setDetectorBand(float frequency, float quality) noexcept;
+
+    // Feeds up to getNumSamplesUntilUpdate() samples of the detector signal (mixed down
+    // to mono). Returns the gain reduction in dB, 0 or more, which moves when this
+    // completes an interval.
+    float process(const float* const* detectorChannels, int numChannels, int numSamples) noexcept;
+
+    int getNumSamplesUntilUpdate() const { return controlInterval - intervalPosition; }
+
+    float getGainReduction() const { return gainReduction; }
+
+private:
+    static float smoothingCoefficient(float timeMs, int numSamples, double sampleRate) noexcept;
+
+    EQEngine detector;
+    std::array<float, controlInterval> scratch {};
+
+    DynamicSettings settings;
+    double sampleRate = 0;
+    float detectorFrequency = 0, detectorQuality = 0;
+
+    // per control interval
+    float attackCoefficient = 0, releaseCoefficient = 0;
+
+    int intervalPosition = 0;
+    float intervalPeak = 0;
+
+    float envelopeInDecibels = -100.f;
+    float gainReduction = 0;
+};
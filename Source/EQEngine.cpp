@@ -0,0 +1,436 @@
+/*
+  ==============================================================================
+
+    EQEngine.cpp
+
+  ==============================================================================
+*/
+
+#include "EQEngine.h"
+#include "CoefficientStore.h"
+
+//==============================================================================
+// Audio EQ cookbook (R. Bristow-Johnson) biquads, designed in double and stored as
+// float like juce::dsp::IIR::Coefficients. The cuts are Butterworth cascades of
+// second order sections, with the same section Qs as
+// FilterDesign::designIIR...HighOrderButterworthMethod.
+
+namespace
+{
+    void setSection(EQDesign& design, int section,
+                    double b0, double b1, double b2,
+                    double a0, double a1, double a2) noexcept
+    {
+        auto s = (size_t) section;
+        auto scale = 1.0 / a0;
+
+        design.b0[s] = (float) (b0 * scale);
+        design.b1[s] = (float) (b1 * scale);
+        design.b2[s] = (float) (b2 * scale);
+        design.a1[s] = (float) (a1 * scale);
+        design.a2[s] = (float) (a2 * scale);
+    }
+    
+    void toStore(const EQDesign& design, int band, CoefficientStore::BandCoefficients& c) noexcept
+    {
+        auto first = band * EQDesign::maxSectionsPerBand;
+        c.numSections = design.getNumSections(band);
+        
+        for( int i = 0; i < c.numSections; ++i )
+        {
+            auto s = (size_t) (first + i);
+            c.b0[i] = design.b0[s]; c.b1[i] = design.b1[s]; c.b2[i] = design.b2[s];
+            c.a1[i] = design.a1[s]; c.a2[i] = design.a2[s];
+        }
+        
+        c.peakCosOmega = design.peakCosOmega[(size_t) band];
+        c.peakAlpha = design.peakAlpha[(size_t) band];
+    }
+    
+    void fromStore(EQDesign& design, int band, const CoefficientStore::BandCoefficients& c) noexcept
+    {
+        auto first = band * EQDesign::maxSectionsPerBand;
+        
+        for( int i = 0; i < c.numSections; ++i )
+        {
+            auto s = (size_t) (first + i);
+            design.b0[s] = c.b0[i]; design.b1[s] = c.b1[i]; design.b2[s] = c.b2[i];
+            design.a1[s] = c.a1[i]; design.a2[s] = c.a2[i];
+        }
+        
+        design.peakCosOmega[(size_t) band] = c.peakCosOmega;
+        design.peakAlpha[(size_t) band] = c.peakAlpha;
+        design.numSections[(size_t) band] = (uint8_t) c.numSections;
+    }
+}
+
+void EQDesign::setBand(int band, const BandSettings& settings, double sampleRate, CoefficientStore* store) noexcept
+{
+    jassert( juce::isPositiveAndBelow(band, maxBands) );
+
+    if( sampleRate <= 0 )
+    {
+        clearBand(band);
+        return;
+    }
+
+    bands[(size_t) band] = settings;
+
+    CoefficientStore::BandCoefficients stored;
+    if( store != nullptr && store->lookup(settings, sampleRate, stored) )
+    {
+        fromStore(*this, band, stored);
+        return;
+    }
+
+    auto frequency = juce::jlimit(2.0, sampleRate * 0.499, (double) settings.frequency);
+    auto omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+    auto cosOmega = std::cos(omega);
+    auto sinOmega = std::sin(omega);
+    auto quality = juce::jmax(0.01, (double) settings.quality);
+    auto alpha = sinOmega / (2.0 * quality);
+    auto A = std::pow(10.0, settings.gainInDecibels / 40.0);
+
+    auto first = band * maxSectionsPerBand;
+    auto count = 1;
+
+    switch( settings.type )
+    {
+        case PeakBand:
+        {
+            peakCosOmega[(size_t) band] = cosOmega;
+            peakAlpha[(size_t) band] = alpha;
+
+            setSection(*this, first,
+                       1.0 + alpha * A, -2.0 * cosOmega, 1.0 - alpha * A,
+                       1.0 + alpha / A, -2.0 * cosOmega, 1.0 - alpha / A);
+            break;
+        }
+        case LowShelfBand:
+        {
+            auto twoSqrtAAlpha = 2.0 * std::sqrt(A) * alpha;
+            setSection(*this, first,
+                       A * ((A + 1.0) - (A - 1.0) * cosOmega + twoSqrtAAlpha),
+                       2.0 * A * ((A - 1.0) - (A + 1.0) * cosOmega),
+                       A * ((A + 1.0) - (A - 1.0) * cosOmega - twoSqrtAAlpha),
+                       (A + 1.0) + (A - 1.0) * cosOmega + twoSqrtAAlpha,
+                       -2.0 * ((A - 1.0) + (A + 1.0) * cosOmega),
+                       (A + 1.0) + (A - 1.0) * cosOmega - twoSqrtAAlpha);
+            break;
+        }
+        case HighShelfBand:
+        {
+            auto twoSqrtAAlpha = 2.0 * std::sqrt(A) * alpha;
+            setSection(*this, first,
+                       A * ((A + 1.0) + (A - 1.0) * cosOmega + twoSqrtAAlpha),
+                       -2.0 * A * ((A - 1.0) + (A + 1.0) * cosOmega),
+                       A * ((A + 1.0) + (A - 1.0) * cosOmega - twoSqrtAAlpha),
+                       (A + 1.0) - (A - 1.0) * cosOmega + twoSqrtAAlpha,
+                       2.0 * ((A - 1.0) - (A + 1.0) * cosOmega),
+                       (A + 1.0) - (A - 1.0) * cosOmega - twoSqrtAAlpha);
+            break;
+        }
+        case NotchBand:
+        {
+            setSection(*this, first,
+                       1.0, -2.0 * cosOmega, 1.0,
+                       1.0 + alpha, -2.0 * cosOmega, 1.0 - alpha);
+            break;
+        }
+        case BandPassBand:
+        {
+            // 0 dB at the centre
+            setSection(*this, first,
+                       alpha, 0.0, -alpha,
+                       1.0 + alpha, -2.0 * cosOmega, 1.0 - alpha);
+            break;
+        }
+        case LowCutBand:
+        case HighCutBand:
+        {
+            auto order = juce::jlimit(2, 2 * maxSectionsPerBand, settings.order & ~1);
+            count = order / 2;
+
+            for( int i = 0; i < count; ++i )
+            {
+                auto sectionQuality = 1.0 / (2.0 * std::cos((2.0 * i + 1.0) * juce::MathConstants<double>::pi / (order * 2.0)));
+                auto sectionAlpha = sinOmega / (2.0 * sectionQuality);
+
+                if( settings.type == LowCutBand )
+                    setSection(*this, first + i,
+                               (1.0 + cosOmega) * 0.5, -(1.0 + cosOmega), (1.0 + cosOmega) * 0.5,
+                               1.0 + sectionAlpha, -2.0 * cosOmega, 1.0 - sectionAlpha);
+                else
+                    setSection(*this, first + i,
+                               (1.0 - cosOmega) * 0.5, 1.0 - cosOmega, (1.0 - cosOmega) * 0.5,
+                               1.0 + sectionAlpha, -2.0 * cosOmega, 1.0 - sectionAlpha);
+            }
+            break;
+        }
+    }
+
+    numSections[(size_t) band] = (uint8_t) count;
+
+    if( store != nullptr )
+    {
+        toStore(*this, band, stored);
+        store->insert(settings, sampleRate, stored);
+    }
+}
+
+void EQDesign::copyBand(const EQDesign& other, int band) noexcept
+{
+    auto b = (size_t) band;
+    bands[b] = other.bands[b];
+    numSections[b] = other.numSections[b];
+    peakCosOmega[b] = other.peakCosOmega[b];
+    peakAlpha[b] = other.peakAlpha[b];
+
+    auto first = (size_t) (band * maxSectionsPerBand);
+    for( size_t s = first; s < first + (size_t) maxSectionsPerBand; ++s )
+    {
+        b0[s] = other.b0[s]; b1[s] = other.b1[s]; b2[s] = other.b2[s];
+        a1[s] = other.a1[s]; a2[s] = other.a2[s];
+    }
+}
+
+void EQDesign::setPeakGain(int band, float gainInDecibels) noexcept
+{
+    jassert( bands[(size_t) band].type == PeakBand );
+
+    if( numSections[(size_t) band] == 0 )
+        return;
+
+    bands[(size_t) band].gainInDecibels = gainInDecibels;
+
+    auto cosOmega = peakCosOmega[(size_t) band];
+    auto alpha = peakAlpha[(size_t) band];
+    auto A = std::pow(10.0, gainInDecibels / 40.0);
+
+    setSection(*this, band * maxSectionsPerBand,
+               1.0 + alpha * A, -2.0 * cosOmega, 1.0 - alpha * A,
+               1.0 + alpha / A, -2.0 * cosOmega, 1.0 - alpha / A);
+}
+
+void EQDesign::clearBand(int band) noexcept
+{
+    jassert( juce::isPositiveAndBelow(band, maxBands) );
+    numSections[(size_t) band] = 0;
+}
+
+//============================================================================== ENGINE //==============================================================================
+
+namespace
+{
+    template <typename Function>
+    void forEachLane(int lane, Function&& function)
+    {
+        if( lane == EQEngine::allLanes )
+        {
+            for( int i = 0; i < EQEngine::numLanes; ++i )
+                function(i);
+        }
+        else
+        {
+            jassert( juce::isPositiveAndBelow(lane, EQEngine::numLanes) );
+            function(lane);
+        }
+    }
+}
+
+void EQEngine::reset() noexcept
+{
+    for( auto& state : states )
+    {
+        for( auto& z : state.z1 )
+            z.fill(0.f);
+        for( auto& z : state.z2 )
+            z.fill(0.f);
+
+        state.samplesSinceSnap = 0;
+    }
+}
+
+void EQEngine::setBand(int band, const BandSettings& settings, double sampleRate, int lane) noexcept
+{
+    // linked lanes share one design, the first lane designs and the others copy
+    auto* designed = (const EQDesign*) nullptr;
+
+    forEachLane(lane, [&](int i)
+    {
+        auto previous = designs[(size_t) i].getNumSections(band);
+
+        if( designed != nullptr )
+            designs[(size_t) i].copyBand(*designed, band);
+        else
+            designs[(size_t) i].setBand(band, settings, sampleRate, store);
+
+        designed = &designs[(size_t) i];
+        bandChanged(band, i, previous);
+    });
+
+    rebuildActiveSections();
+}
+
+void EQEngine::clearBand(int band, int lane) noexcept
+{
+    forEachLane(lane, [&](int i) { designs[(size_t) i].clearBand(band); });
+    rebuildActiveSections();
+}
+
+void EQEngine::setPeakGain(int band, float gainInDecibels, int lane) noexcept
+{
+    // the section list stays, only its coefficients move
+    forEachLane(lane, [&](int i) { designs[(size_t) i].setPeakGain(band, gainInDecibels); });
+
+    if( designs[0].isBandActive(band) || designs[1].isBandActive(band) )
+        updateCoefficients(band * EQDesign::maxSectionsPerBand);
+}
+
+void EQEngine::setDesign(const EQDesign& newDesign, int lane) noexcept
+{
+    forEachLane(lane, [&](int i)
+    {
+        auto previous = designs[(size_t) i].numSections;
+        designs[(size_t) i] = newDesign;
+
+        for( int band = 0; band < EQDesign::maxBands; ++band )
+            bandChanged(band, i, previous[(size_t) band]);
+    });
+
+    rebuildActiveSections();
+}
+
+void EQEngine::bandChanged(int band, int lane, int previousNumSections) noexcept
+{
+    // sections that were idle carry stale state, they start from silence
+    auto first = band * EQDesign::maxSectionsPerBand;
+
+    for( int i = previousNumSections; i < designs[(size_t) lane].getNumSections(band); ++i )
+    {
+        for( auto& state : states )
+        {
+            state.z1[(size_t) (first + i)][(size_t) lane] = 0.f;
+            state.z2[(size_t) (first + i)][(size_t) lane] = 0.f;
+        }
+    }
+}
+
+void EQEngine::rebuildActiveSections() noexcept
+{
+    numActiveSections = 0;
+
+    for( int band = 0; band < EQDesign::maxBands; ++band )
+    {
+        auto first = band * EQDesign::maxSectionsPerBand;
+        auto count = juce::jmax(designs[0].getNumSections(band), designs[1].getNumSections(band));
+
+        for( int i = 0; i < count; ++i )
+        {
+            listIndex[(size_t) (first + i)] = (uint8_t) numActiveSections;
+            activeSections[(size_t) numActiveSections++] = (uint8_t) (first + i);
+            updateCoefficients(first + i);
+        }
+    }
+}
+
+void EQEngine::updateCoefficients(int section) noexcept
+{
+    auto& c = coefficients[(size_t) listIndex[(size_t) section]];
+    auto band = section / EQDesign::maxSectionsPerBand;
+    auto s = (size_t) section;
+
+    for( int lane = 0; lane < numLanes; ++lane )
+    {
+        auto& design = designs[(size_t) lane];
+
+        // a section this lane does not use passes its input through
+        auto used = section - band * EQDesign::maxSectionsPerBand < design.getNumSections(band);
+
+        c.b0[lane] = used ? design.b0[s] : 1.f;
+        c.b1[lane] = used ? design.b1[s] : 0.f;
+        c.b2[lane] = used ? design.b2[s] : 0.f;
+        c.a1[lane] = used ? design.a1[s] : 0.f;
+        c.a2[lane] = used ? design.a2[s] : 0.f;
+    }
+}
+
+void EQEngine::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    for( int pair = 0; pair < getNumPairs(numChannels); ++pair )
+        processPair(pair, channels, numChannels, numSamples);
+}
+
+void EQEngine::processPair(int pair, float* const* channels, int numChannels, int numSamples) noexcept
+{
+    jassert( juce::isPositiveAndBelow(pair, getNumPairs(numChannels)) );
+
+    auto& state = states[(size_t) pair];
+    auto& z1 = state.z1;
+    auto& z2 = state.z2;
+
+    auto* left = channels[pair * 2];
+    auto* right = pair * 2 + 1 < juce::jmin(numChannels, maxChannels) ? channels[pair * 2 + 1] : nullptr;
+
+    for( int n = 0; n < numActiveSections; ++n )
+    {
+        auto s = (size_t) activeSections[(size_t) n];
+        const auto& c = coefficients[(size_t) n];
+
+        if( right != nullptr )
+        {
+            // Both lanes in one register. In mid/side the first section encodes and the
+            // last decodes, on the way through, so there is no extra pass and no buffer.
+            auto encode = midSide && n == 0;
+            auto decode = midSide && n == numActiveSections - 1;
+
+            if( encode && decode )
+                SIMDKernels::processBiquadPair<true, true>(left, right, numSamples, c, z1[s].data(), z2[s].data());
+            else if( encode )
+                SIMDKernels::processBiquadPair<true, false>(left, right, numSamples, c, z1[s].data(), z2[s].data());
+            else if( decode )
+                SIMDKernels::processBiquadPair<false, true>(left, right, numSamples, c, z1[s].data(), z2[s].data());
+            else
+                SIMDKernels::processBiquadPair<false, false>(left, right, numSamples, c, z1[s].data(), z2[s].data());
+        }
+        else
+        {
+            // a single channel has no side, lane 0 only
+            auto stateZ1 = z1[s][0], stateZ2 = z2[s][0];
+
+            const auto b0 = c.b0[0], b1 = c.b1[0], b2 = c.b2[0];
+            const auto a1 = c.a1[0], a2 = c.a2[0];
+
+            for( int i = 0; i < numSamples; ++i )
+            {
+                auto x = left[i];
+                auto y = b0 * x + stateZ1;
+                stateZ1 = b1 * x - a1 * y + stateZ2;
+                stateZ2 = b2 * x - a2 * y;
+                left[i] = y;
+            }
+
+            z1[s][0] = stateZ1;
+            z2[s][0] = stateZ2;
+        }
+    }
+
+    // Like IIR::Filter::snapToZero, keeps decaying state out of the denormal range. Once
+    // per snapInterval samples is plenty for that, and spares tiny blocks the cost.
+    state.samplesSinceSnap += numSamples;
+    if( state.samplesSinceSnap < snapInterval )
+        return;
+
+    state.samplesSinceSnap = 0;
+
+    for( int n = 0; n < numActiveSections; ++n )
+    {
+        auto s = (size_t) activeSections[(size_t) n];
+
+        for( int lane = 0; lane < numLanes; ++lane )
+        {
+            juce::dsp::util::snapToZero(z1[s][(size_t) lane]);
+            juce::dsp::util::snapToZero(z2[s][(size_t) lane]);
+        }
+    }
+}
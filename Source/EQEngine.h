@@ -0,0 +1,161 @@
+/*
+  ==============================================================================
+
+    EQEngine.h
+
+    Data-oriented N-band biquad engine.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDKernels.h"
+#include <array>
+#include <cstdint>
+
+class CoefficientStore;
+
+enum BandType
+{
+    PeakBand,
+    LowShelfBand,
+    HighShelfBand,
+    NotchBand,
+    BandPassBand,
+    LowCutBand,
+    HighCutBand
+};
+
+struct BandSettings
+{
+    BandType type = PeakBand;
+    float frequency = 1000.f;
+    float gainInDecibels = 0.f;         // peak and shelves
+    float quality = 0.70710678f;        // peak, shelves, notch and band-pass
+    int order = 2;                      // cuts only: 2, 4, 6 or 8, i.e. 12 to 48 db/Oct
+};
+
+//============================================================================== DESIGN //==============================================================================
+/*
+ The coefficients of up to maxBands bands, as normalised biquad sections (a0 == 1) in a
+ structure of arrays. Band b owns the sections from b * maxSectionsPerBand on, the cuts
+ use one section per 12 db/Oct, every other type one.
+
+ Designing never allocates, so it is fine on any thread, the audio thread included.
+ */
+struct EQDesign
+{
+    static constexpr int maxBands = 24;
+    static constexpr int maxSectionsPerBand = 4;
+    static constexpr int maxSections = maxBands * maxSectionsPerBand;
+
+    // with a store, a band designed before anywhere in the process is copied from there
+    void setBand(int band, const BandSettings& settings, double sampleRate, CoefficientStore* store = nullptr) noexcept;
+    void clearBand(int band) noexcept;
+
+    // takes over one band of another design as it is
+    void copyBand(const EQDesign& other, int band) noexcept;
+
+    // only for peak bands, reuses the band's frequency terms, no trigonometry
+    void setPeakGain(int band, float gainInDecibels) noexcept;
+
+    bool isBandActive(int band) const { return numSections[(size_t) band] > 0; }
+    const BandSettings& getBand(int band) const { return bands[(size_t) band]; }
+    int getNumSections(int band) const { return numSections[(size_t) band]; }
+
+    std::array<BandSettings, maxBands> bands;
+    std::array<uint8_t, maxBands> numSections {};
+
+    std::array<float, maxSections> b0 {}, b1 {}, b2 {}, a1 {}, a2 {};
+
+    // cos(w0) and alpha of every peak band, for setPeakGain
+    std::array<double, maxBands> peakCosOmega {}, peakAlpha {};
+};
+
+//============================================================================== ENGINE //==============================================================================
+/*
+ Runs up to two lanes of EQ over up to maxChannels channels, in place. Channels go in
+ pairs, every pair through both lanes, so a wide bus is several stereo pairs with one
+ design (a channel left over at the end runs alone, on lane 0).
+
+ In linked stereo both lanes carry the same design. In mid/side the lanes are mid and
+ side, each with a design of its own, and the conversion to and from mid/side rides on
+ the first and last section, see SIMDKernels::processBiquadPair. That happens on every
+ pair, so on a bus wider than stereo the processor keeps the engine linked.
+
+ The engine keeps a packed list of the sections that are in use by either lane, with
+ both lanes' coefficients next to each other, processing is one loop over that list
+ with both channels in the same pass over the samples. A section only one lane uses is
+ a pass-through on the other. Adding or removing a band only rewrites the list, nothing
+ is ever allocated after construction.
+
+ The filter state is per pair, each pair's on cache lines of its own. Pairs share
+ nothing but the coefficients, which processing only reads, so different pairs can be
+ processed on different threads at the same time, see processPair.
+ */
+class EQEngine
+{
+public:
+    static constexpr int numLanes = 2;
+    static constexpr int allLanes = -1;
+    static constexpr int maxChannels = 16;
+    static constexpr int maxPairs = maxChannels / 2;
+
+    // the state is checked for values decaying towards denormals this often, at most
+    static constexpr int snapInterval = 32;
+
+    static int getNumPairs(int numChannels) { return (juce::jmin(numChannels, maxChannels) + 1) / 2; }
+
+    // clears the filter state, the design stays
+    void reset() noexcept;
+
+    // the process-wide store setBand looks designs up in, nullptr designs everything here
+    void setCoefficientStore(CoefficientStore* storeToUse) noexcept { store = storeToUse; }
+
+    // the lanes' filter state means something else after a switch, reset or crossfade
+    void setMidSide(bool shouldUseMidSide) noexcept { midSide = shouldUseMidSide; }
+    bool isMidSide() const { return midSide; }
+
+    // designs in place, safe on the audio thread
+    void setBand(int band, const BandSettings& settings, double sampleRate, int lane = allLanes) noexcept;
+    void clearBand(int band, int lane = allLanes) noexcept;
+
+    // gain-only update of a peak band, e.g. for the dynamic EQ
+    void setPeakGain(int band, float gainInDecibels, int lane = allLanes) noexcept;
+
+    // takes over a complete design made somewhere else
+    void setDesign(const EQDesign& newDesign, int lane = allLanes) noexcept;
+    const EQDesign& getDesign(int lane = 0) const { return designs[(size_t) lane]; }
+
+    int getNumActiveSections() const { return numActiveSections; }
+
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+    // channels 2 * pair and 2 * pair + 1 only, one thread per pair may run this concurrently
+    void processPair(int pair, float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    void bandChanged(int band, int lane, int previousNumSections) noexcept;
+    void rebuildActiveSections() noexcept;
+    void updateCoefficients(int section) noexcept;
+
+    std::array<EQDesign, numLanes> designs;
+    bool midSide = false;
+    CoefficientStore* store = nullptr;
+
+    std::array<uint8_t, EQDesign::maxSections> activeSections {};
+    std::array<SIMDKernels::BiquadPair, EQDesign::maxSections> coefficients {};     // per list entry
+    std::array<uint8_t, EQDesign::maxSections> listIndex {};                         // per section
+    int numActiveSections = 0;
+
+    // transposed direct form II state of one pair, [section][lane]
+    struct alignas(64) PairState
+    {
+        std::array<std::array<float, numLanes>, EQDesign::maxSections> z1 {}, z2 {};
+        int samplesSinceSnap = 0;
+    };
+
+    std::array<PairState, maxPairs> states;
+};
@@ -8,6 +8,7 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ResponseVerifier.h"
 
 
 ResponseCurveComponent::ResponseCurveComponent(LAUTEQAudioProcessor& p) : audioProcessor(p),
@@ -15,8 +16,7 @@ ResponseCurveComponent::ResponseCurveComponent(LAUTEQAudioProcessor& p) : audioP
 
 //==============================================================================  Initialize FIFO
 
-                                                                        leftPathProducer(audioProcessor.leftChannelFifo),
-                                                                        rightPathProducer(audioProcessor.rightChannelFifo)
+                                                                        pathProducer(audioProcessor.leftChannelFifo, audioProcessor.rightChannelFifo)
 
 //==============================================================================
 
@@ -36,7 +36,15 @@ ResponseCurveComponent::ResponseCurveComponent(LAUTEQAudioProcessor& p) : audioP
     
     updateChain();
     
-    startTimerHz(60000);
+    pathProducer.setRecorder(&spectrumRecorder);
+    
+    // start feeding the analyzer fifos
+    audioProcessor.addAnalyzerSubscriber();
+    
+    // the background layer covers everything, so the editor never has to paint behind us
+    setOpaque(true);
+    
+    startTimerHz(frameScheduler.getTimerHz());
 }
 
 
@@ -45,6 +53,8 @@ ResponseCurveComponent::ResponseCurveComponent(LAUTEQAudioProcessor& p) : audioP
 
 ResponseCurveComponent::~ResponseCurveComponent()
 {
+    audioProcessor.removeAnalyzerSubscriber();
+    
     const auto& params = audioProcessor.getParameters();
     for ( auto param : params )
     {
@@ -64,36 +74,63 @@ void ResponseCurveComponent::parameterValueChanged (int parameterIndex, float ne
  // ============================================================================== PATH PRODUCER // ==============================================================================
 
 
-void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
+bool PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
 {
-    /// Temporary Buffer
-    juce::AudioBuffer<float> tempIncomingBuffer;
+    bool hasNewContent = false;
     
-    // while more than 0 buffer available
-    while ( leftChannelFifo->getNumCompleteBuffersAvailable() > 0)
+    auto shiftIntoMonoBuffer = [this](juce::AudioBuffer<float>& monoBuffer)
+    {
+        // get size of incoming buffer
+        auto size = tempIncomingBuffer.getNumSamples();
+        
+        
+        // Shifting data
+        juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0,0),          // init with index 0
+                                          monoBuffer.getReadPointer(0, size),         // everything after the oldest block
+                                          monoBuffer.getNumSamples() - size);       // shift next block size to Gui
+        
+        // Copying from temp buffer to mono buffer data
+        juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size), // copy to mono buffer with sample index shift next block 
+                                          tempIncomingBuffer.getReadPointer(0, 0),      // source temp incoming Buffer
+                                          size);                                        // Copy samples in Size data
+    };
+    
+    // while both channels have a buffer available
+    // (both fifos are fed from the same processBlock, so they stay in step)
+    while ( leftChannelFifo->getNumCompleteBuffersAvailable() > 0 &&
+            rightChannelFifo->getNumCompleteBuffersAvailable() > 0 )
     {
         // pull get audio buffer
         if (leftChannelFifo->getAudioBuffer(tempIncomingBuffer) )
+            shiftIntoMonoBuffer(leftMonoBuffer);
+        
+        if (rightChannelFifo->getAudioBuffer(tempIncomingBuffer) )
+            shiftIntoMonoBuffer(rightMonoBuffer);
+        
+        // Sending Buffers to FFT Data Generator //Producing FFT Data Blocks, one transform for both
         {
-            // get size of incoming buffer
-            auto size = tempIncomingBuffer.getNumSamples();
-            
-            
-            // Shifting data
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0,0),          // init with index 0
-                                              monoBuffer.getReadPointer(0, size/2),       // start with first block and size // select every second
-                                              monoBuffer.getNumSamples() - size);       // shift next block size to Gui
-            
-            // Copying from temp buffer to mono buffer data
-            juce::FloatVectorOperations::copy(monoBuffer.getWritePointer(0, monoBuffer.getNumSamples() - size), // copy to mono buffer with sample index shift next block 
-                                              tempIncomingBuffer.getReadPointer(0, 0),      // source temp incoming Buffer
-                                              size);                                        // Copy samples in Size data
-            
-            
-            // Sending Buffers to FFT Data Generator //Producing FFT Data Blocks 
-            leftChannelFFTDataGenerator.produceFFTDataForRendering(monoBuffer, -48.f);
-            
+            LAUTEQ_TRACE_SCOPE("analyzer FFT");
+            fftDataGenerator.produceFFTDataForRendering(leftMonoBuffer, rightMonoBuffer, -48.f);
         }
+        
+        // the recorder copies the frame into its own ring, writing happens on its thread
+        if( recorder != nullptr && recorder->isRecording() )
+        {
+            const float* traces[] { fftDataGenerator.getLatestFFTData(0).data(),
+                                    fftDataGenerator.getLatestFFTData(1).data() };
+            recorder->pushFrame(traces, fftDataGenerator.getNumTraces(), fftDataGenerator.getFFTSize() / 2,
+                                sampleRate, fftDataGenerator.getOrder());
+        }
+        
+        // a silent frame after a silent frame looks exactly the same
+        auto silent = fftDataGenerator.isLastFrameSilent();
+        hasNewContent = hasNewContent || ! (silent && previousFrameSilent);
+        previousFrameSilent = silent;
+        
+        // only the newest frame gets drawn, so only that one waits for a path
+        if( leftChannelFifo->getNumCompleteBuffersAvailable() > 0 &&
+            rightChannelFifo->getNumCompleteBuffersAvailable() > 0 )
+            fftDataGenerator.discardFFTData();
     }
     
     // If there are fft data buffers to pull
@@ -101,7 +138,7 @@ void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
             // generate a path
     
 //    const auto fftBounds = getAnalysisArea().toFloat();                   // Bounding box
-    const auto fftSize = leftChannelFFTDataGenerator.getFFTSize();          // get fftsize
+    const auto fftSize = fftDataGenerator.getFFTSize();                     // get fftsize
     
     /*
      44100 khz / 2048 Bins = 23Hz pro Band
@@ -109,26 +146,50 @@ void PathProducer::process(juce::Rectangle<float> fftBounds, double sampleRate)
     const auto binWidth = sampleRate / (double)fftSize;                     //
     
     // while it has fft blocks
-    while (leftChannelFFTDataGenerator.getNumAvailableFFTDataBlocks() > 0)
+    while (fftDataGenerator.getNumAvailableFFTDataBlocks() > 0)
     {
-        // get fft blocks
-        std::vector<float> fftdata;     // History
-        if ( leftChannelFFTDataGenerator.getFFTData(fftdata) )
+        for( int trace = 0; trace < getNumPaths(); ++trace )
         {
-            //if we able to pull fft blocks
-            pathProducer.generatePath(fftdata, fftBounds, fftSize, binWidth, -48.f);
+            // get fft blocks
+            if ( fftDataGenerator.getFFTData(trace, fftFrame) )
+            {
+                //if we able to pull fft blocks
+                pathProducers[trace].generatePath(fftFrame, fftBounds, fftSize, binWidth, -48.f);
+                
+                // pulled straight away, so the path fifo never holds more than this one
+                while (pathProducers[trace].getNumPathsAvailable() )
+                {
+                    pathProducers[trace].getPath(fftPaths[trace]);
+                }
+            }
         }
     }
     
+    return hasNewContent;
+}
+
+AnalyzerMemoryReport PathProducer::getMemoryUsage() const
+{
+    AnalyzerMemoryReport report;
+    report.sampleFifos = leftChannelFifo->getMemoryUsage() + rightChannelFifo->getMemoryUsage();
+    report.sampleFifoBlocks = leftChannelFifo->getNumBlocks();
     
-    // while there are paths that can be pull
-    // pull as many as we can
-    // display the most recent
+    fftDataGenerator.addMemoryUsage(report);
     
-    while (pathProducer.getNumPathsAvailable() )
-    {
-        pathProducer.getPath(leftChannelFFTPath);
-    }
+    for( auto& generator : pathProducers )
+        report.pathFifos += generator.getMemoryUsage();
+    
+    report.workingBuffers += arena.getSize();
+    return report;
+}
+
+void PathProducer::setView(AnalyzerView newView)
+{
+    fftDataGenerator.setView(newView);
+    
+    // drop traces the new view doesn't produce
+    for( int trace = getNumPaths(); trace < (int) fftPaths.size(); ++trace )
+        fftPaths[trace].clear();
 }
 
 
@@ -141,19 +202,27 @@ void ResponseCurveComponent::timerCallback()
     auto fftBounds = getAnalysisArea().toFloat();
     auto samplerate = audioProcessor.getSampleRate();
     
-    leftPathProducer.process(fftBounds, samplerate);
-    rightPathProducer.process(fftBounds, samplerate);
+    auto hasNewContent = pathProducer.process(fftBounds, samplerate);
     
-    startTimer(100/20);
+    if (hasNewContent)
+        pushSpectrumFrame();
     
     
-    if (parametersChanged.compareAndSetBool(false, true) )
+    // the response curve only changes with the parameters or the sample rate
+    if (parametersChanged.compareAndSetBool(false, true) || samplerate != columnTableSampleRate )
     {
         updateChain();
-     //   repaint();
+        updateResponseCurve();
+        hasNewContent = true;
     }
     
-    repaint();
+    if (frameScheduler.tick(hasNewContent))
+        repaint();
+    
+    // fast while things move, slow once they have settled
+    auto timerHz = frameScheduler.getTimerHz();
+    if (getTimerInterval() != 1000 / timerHz)
+        startTimerHz(timerHz);
     
 }
 
@@ -162,76 +231,82 @@ void ResponseCurveComponent::timerCallback()
 void ResponseCurveComponent::updateChain()
 {
     auto chainSettings = getChainSettings(audioProcessor.apvts);
-    auto peakCoefficiens = makePeakFilter(chainSettings, audioProcessor.getSampleRate());
-    updateCoefficients(monoChain.get<ChainPositions::Peak>().coefficients, peakCoefficiens);
-    
-    auto lowCutCoefficients = makeLowCutFilter(chainSettings, audioProcessor.getSampleRate());
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, audioProcessor.getSampleRate());
-    
-    
-    updateCutFilter(monoChain.get<ChainPositions::LowCut>(), lowCutCoefficients, chainSettings.lowCutSlope);
-    updateCutFilter(monoChain.get<ChainPositions::HighCut>(), highCutCoefficients, chainSettings.lowCutSlope);
-    
+    setChainBands(responseDesign, chainSettings, audioProcessor.getSampleRate());
 }
+
  // ==============================================================================
-void ResponseCurveComponent::paint (juce::Graphics& g)
+
+void ResponseCurveComponent::resized()
 {
-    g.fillAll(Colours::black);
+    backgroundLayerDirty = true;
+    updateResponseCurve();
+}
+
+void ResponseCurveComponent::updateColumnTables()
+{
+    auto w = getLocalBounds().getWidth();
+    auto samplerate = audioProcessor.getSampleRate();
     
+    columnCos.resize(w);
+    columnSin.resize(w);
+    columnCos2.resize(w);
+    columnSin2.resize(w);
     
-    auto responseArea = getLocalBounds();
-//    auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    // e^{-jw} and e^{-j2w} for the frequency under every pixel column
+    for( int i=0; i<w; i++)
+    {
+        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
+        auto omega = MathConstants<double>::twoPi * freq / samplerate;
+        
+        columnCos[i] = (float) std::cos(omega);
+        columnSin[i] = (float) std::sin(omega);
+        columnCos2[i] = (float) std::cos(2.0 * omega);
+        columnSin2[i] = (float) std::sin(2.0 * omega);
+    }
     
+    columnTableSampleRate = samplerate;
+}
+
+void ResponseCurveComponent::updateResponseCurve()
+{
+    auto responseArea = getLocalBounds();
     auto w = responseArea.getWidth();
+    auto samplerate = audioProcessor.getSampleRate();
     
-    auto& lowcut = monoChain.get<ChainPositions::LowCut>();
-    auto& peak = monoChain.get<ChainPositions::Peak>();
-    auto& highcut = monoChain.get<ChainPositions::HighCut>();
+    responseCurve.clear();
+    curveLayerDirty = true;
     
-    auto samplerate = audioProcessor.getSampleRate();
+    if( w <= 0 || samplerate <= 0 )
+        return;
     
-    std::vector<double> mags;
+    if( (int) columnCos.size() != w || columnTableSampleRate != samplerate )
+        updateColumnTables();
     
-    mags.resize(w);
+    // all sections are evaluated for all columns at once, as |H|^2 products
+    responseMags.resize(w);
+    FloatVectorOperations::fill(responseMags.data(), 1.f, w);
     
-    for( int i=0; i<w; i++)
+    for( int band = 0; band < EQDesign::maxBands; ++band )
     {
-        double mag = 1.f;
-        auto freq = mapToLog10(double(i) / double(w), 20.0, 20000.0);
-        
-        if(! monoChain.isBypassed<ChainPositions::Peak>() )
-            mag *= peak.coefficients->getMagnitudeForFrequency(freq, samplerate);
-        
-        if(! lowcut.isBypassed<0>() )
-            mag *= lowcut.get<0>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! lowcut.isBypassed<1>() )
-            mag *= lowcut.get<1>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! lowcut.isBypassed<2>() )
-            mag *= lowcut.get<2>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! lowcut.isBypassed<3>() )
-            mag *= lowcut.get<3>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        
-        if(! highcut.isBypassed<0>() )
-            mag *= highcut.get<0>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! highcut.isBypassed<1>() )
-            mag *= highcut.get<1>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! highcut.isBypassed<2>() )
-            mag *= highcut.get<2>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        if(! highcut.isBypassed<3>() )
-            mag *= highcut.get<3>().coefficients->getMagnitudeForFrequency(freq, samplerate);
-        
-        
-        mags[i] = Decibels::gainToDecibels(mag);
+        for( int i = 0; i < responseDesign.getNumSections(band); ++i )
+        {
+            auto section = (size_t) (band * EQDesign::maxSectionsPerBand + i);
+            
+            SIMDKernels::accumulateBiquadPower(responseMags.data(),
+                                               columnCos.data(), columnSin.data(),
+                                               columnCos2.data(), columnSin2.data(),
+                                               w,
+                                               responseDesign.b0[section], responseDesign.b1[section], responseDesign.b2[section],
+                                               responseDesign.a1[section], responseDesign.a2[section]);
+        }
     }
     
+    // power to dB, same floor as Decibels::gainToDecibels
+    SIMDKernels::gainToDecibels(responseMags.data(), w, 1.f, -100.f, SIMDKernels::powerDecibelsPerLog2);
     
      // ==============================================================================
     
     // Response Curve
-    Path responseCurve;
-    
-//    juce::ColourGradient gradient;
- 
     const double outputMin = responseArea.getBottom();
     const double outputMax = responseArea.getY();
     auto map = [outputMin, outputMax](double input)
@@ -239,101 +314,239 @@ void ResponseCurveComponent::paint (juce::Graphics& g)
         return jmap(input, -24.0, 24.0, outputMin, outputMax);
     };
     
+    //Filter Curve DRAW
+    responseCurve.preallocateSpace(3 * w);
+    responseCurve.startNewSubPath(responseArea.getX(), map(responseMags.front()));
     
-     // ==============================================================================
+    for ( size_t i =1; i < responseMags.size(); i++)
+    {
+        responseCurve.lineTo(responseArea.getX() + i, map(responseMags[i]));
+    }
+}
+ // ==============================================================================
+
+void ResponseCurveComponent::setSpectrumLayerSettings(SpectrumLayerSettings newSettings)
+{
+    newSettings.numTrails = juce::jlimit(1, maxSpectrumTrails, newSettings.numTrails);
+    spectrumLayerSettings = newSettings;
     
-//    //Filter Curve DRAW
-//
-//    responseCurve.startNewSubPath(responseArea.getX(), map(mags.front()));
-//
-//
-//    for ( size_t i =1; i < mags.size(); i++)
-//    {
-//        responseCurve.lineTo(responseArea.getX() + i, map(mags[i]));
-//    }
-//
-        // ==============================================================================
+    spectrumLayerDirty = true;
+    repaint();
+}
+
+void ResponseCurveComponent::pushSpectrumFrame()
+{
+    // age the trails by one frame, the oldest one gets overwritten
+    for( int trail = spectrumLayerSettings.numTrails - 1; trail > 0; --trail )
+        for( int trace = 0; trace < 2; ++trace )
+            spectrumTrails[trail][trace].swapWithPath(spectrumTrails[trail - 1][trace]);
+    
+    // the newest frame is swapped in, the oldest trail's storage goes back to the producer.
+    // A trace the view doesn't produce is left empty.
+    for( int trace = 0; trace < 2; ++trace )
+    {
+        if( trace < pathProducer.getNumPaths() )
+            pathProducer.takePath(trace, spectrumTrails[0][trace]);
+        else
+            spectrumTrails[0][trace].clear();
+    }
     
+    spectrumLayerDirty = true;
+}
+
+void ResponseCurveComponent::renderSpectrumLayer()
+{
+    auto responseArea = getLocalBounds();
+    auto numTrails = spectrumLayerSettings.numTrails;
+    auto stroke = PathStrokeType(spectrumLayerSettings.strokeWidth);
+    auto transform = AffineTransform::translation(responseArea.getX()+1, 0);
     
-    //Spectrum
+    // newest frame in blue, older ones fade through green and red
+    const juce::Colour colours[] { juce::Colours::blue, juce::Colours::green, juce::Colours::red };
+    
+    spectrumLayer.render([&](juce::Graphics& lg)
+    {
+        // oldest first so the newest frame ends up on top
+        for( int trail = numTrails - 1; trail >= 0; --trail )
+        {
+            auto colour = colours[juce::jmin(trail, 2)];
+            lg.setColour(colour.withMultipliedAlpha(1.f - float(trail) / float(numTrails)));
+            
+            for( int trace = 0; trace < 2; ++trace )
+                lg.strokePath(spectrumTrails[trail][trace], stroke, transform);
+        }
+    });
+}
+
+void ResponseCurveComponent::renderCurveLayer()
+{
+    curveLayer.render([&](juce::Graphics& lg)
+    {
+        lg.setColour(Colours::white);
+        lg.strokePath(responseCurve, PathStrokeType(2.));
+    });
+}
+
+void ResponseCurveComponent::renderStatsLayer(juce::Rectangle<int> statsArea)
+{
+    const auto& stats = frameScheduler.getStats();
     
+    auto frameText = juce::String(stats.framesPerSecond, 1) + " fps  "
+                   + juce::String(stats.averagePaintMs, 2) + " ms avg  "
+                   + juce::String(stats.maxPaintMs, 2) + " ms max";
     
-    //
+    if( AllocationCounter::isEnabled() )
+        frameText << "  " << juce::String(stats.averageAllocations, 1) << " allocs/frame avg  "
+                  << juce::String((juce::int64) stats.maxAllocations) << " max";
     
+    auto memory = pathProducer.getMemoryUsage();
+    auto& arena = audioProcessor.getBufferArena();
+    auto memoryText = "analyzer " + juce::String((int) (memory.getTotal() / 1024)) + " KB, fifos "
+                    + juce::String((int) (memory.getFifoTotal() / 1024)) + " KB with "
+                    + juce::String(memory.sampleFifoBlocks) + " sample blocks, arena "
+                    + juce::String((int) (arena.getPeakBytes() / 1024)) + " KB peak in "
+                    + juce::String(arena.getNumAllocations()) + " allocations";
     
+    // the layer starts at the overlay's corner, not the component's
+    auto row = statsArea.withZeroOrigin().removeFromTop(14);
     
-    for ( auto y = 0; y < 5; y++ )
+    statsLayer.render([&](juce::Graphics& lg)
     {
+        lg.setColour(Colours::grey);
+        lg.setFont(11.f);
+        lg.drawText(frameText, row, juce::Justification::topLeft);
+        lg.drawText(memoryText, row.translated(0, 14), juce::Justification::topLeft);
+    });
+}
+
+void ResponseCurveComponent::renderBackgroundLayer()
+{
+    auto responseArea = getLocalBounds();
+    auto bounds = responseArea.toFloat();
+    
+    backgroundLayer.render([&](juce::Graphics& lg)
+    {
+        lg.fillAll(Colours::black);
         
-        juce::Array<juce::Colour> colours { juce::Colours::red, juce::Colours::green, juce::Colours::blue };
-        
-        
-        auto rightChannelFFTPath = rightPathProducer.getPath();
-        auto leftChannelFFTPath = leftPathProducer.getPath();
-        
-        // First Spec
-        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX()+1, responseArea.getY()*y));
-        g.setColour(colours[0+y]);
+        // same mappings as the response curve: log frequency across, -24..24 dB up
+        auto mapX = [bounds](float freq)
+        {
+            return bounds.getX() + bounds.getWidth() * juce::mapFromLog10(freq, 20.f, 20000.f);
+        };
         
+        auto mapY = [bounds](float gain)
+        {
+            return juce::jmap(gain, -24.f, 24.f, bounds.getBottom(), bounds.getY());
+        };
         
+        const float freqs[] { 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000 };
+        const float gains[] { -24, -12, 0, 12, 24 };
         
+        // Grid
+        lg.setColour(Colours::dimgrey.withAlpha(0.5f));
+        for( auto f : freqs )
+            lg.drawVerticalLine(juce::roundToInt(mapX(f)), bounds.getY(), bounds.getBottom());
         
-        leftChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX()+1, responseArea.getY()*y));
-        g.setColour(colours[0+y]);
+        for( auto gain : gains )
+        {
+            lg.setColour(gain == 0.f ? Colours::grey.withAlpha(0.6f) : Colours::dimgrey.withAlpha(0.5f));
+            lg.drawHorizontalLine(juce::roundToInt(mapY(gain)), bounds.getX(), bounds.getRight());
+        }
         
-
+        // Labels
+        lg.setFont(10.f);
+        lg.setColour(Colours::lightgrey.withAlpha(0.7f));
         
-        // Draw Specs
-        g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
-        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
+        for( auto f : freqs )
+        {
+            juce::String str;
+            if( f >= 1000.f )
+                str << juce::roundToInt(f / 1000.f) << "k";
+            else
+                str << juce::roundToInt(f);
+            
+            lg.drawText(str, juce::Rectangle<float>(30.f, 12.f).withCentre({ mapX(f), bounds.getY() + 8.f }),
+                        juce::Justification::centred, false);
+        }
         
-//        PathStrokeType (float strokeThickness,
-//                        JointStyle jointStyle,
-//                        EndCapStyle endStyle = butt) noexcept;
+        for( auto gain : gains )
+        {
+            juce::String str;
+            if( gain > 0.f )
+                str << "+";
+            str << juce::roundToInt(gain);
+            
+            lg.drawText(str, juce::Rectangle<float>(24.f, 12.f).withCentre({ bounds.getRight() - 14.f, mapY(gain) }),
+                        juce::Justification::centred, false);
+        }
         
+        // Border
+        lg.setColour(Colours::orange);
+        lg.drawRoundedRectangle(bounds, 4.f, 1.f);
+    });
+}
 
-//
-        
-        // FILL OUT
-//        g.fillPath(rightChannelFFTPath,(AffineTransform().translation(responseArea.getX()+1, responseArea.getY()-0)));
-        
-        
-        
-        // Draw Multiple Lines
-        
-        //Draw Lines to Wish out
-//        for ( double y2 = 0.5; y2 >= 0.0; y2 -= 0.1)
-//        {
-//
-//        rightChannelFFTPath.applyTransform(AffineTransform().translation(responseArea.getX()+5, responseArea.getY()-1*10));
-//        PathStrokeType pst(y2);
-//        g.setColour(colours[0+y]);
-//
-//
-//        //Response curve Definition
-//        g.setColour(Colours::white);
-//        g.strokePath(leftChannelFFTPath, PathStrokeType(1.f));
-//
-//        g.strokePath(rightChannelFFTPath, PathStrokeType(y2));
-//
-//
-//        }
-//
+ // ==============================================================================
+void ResponseCurveComponent::paint (juce::Graphics& g)
+{
+    LAUTEQ_TRACE_SCOPE("ResponseCurveComponent::paint");
+    frameScheduler.paintStarted();
+    
+    auto responseArea = getLocalBounds();
+//    auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
     
+    // Background, grid, labels and border
+    // only rendered again after a resize or when the scale factor changes
+    if (backgroundLayer.prepare(responseArea, scale) || backgroundLayerDirty)
+    {
+        renderBackgroundLayer();
+        backgroundLayerDirty = false;
     }
     
+    g.setOpacity(1.f);
+    backgroundLayer.draw(g, responseArea);
     
-    // Response curve Definition
-    g.setColour(Colours::whitesmoke);
+        // ==============================================================================
     
-    // g.strokePath(rightChannelFFTPath, PathStrokeType(1.f));
     
-    // Filter curve
-    g.setColour(Colours::orange);
-    g.drawRoundedRectangle(responseArea.toFloat(), 4.f, 1.f);
+    //Spectrum
+    // rendered once per analyzer frame, every other paint just blits it
+    if (spectrumLayer.prepare(responseArea, scale) || spectrumLayerDirty)
+    {
+        renderSpectrumLayer();
+        spectrumLayerDirty = false;
+    }
     
-    g.setColour(Colours::white);
-    g.strokePath(responseCurve, PathStrokeType(2.));
+    spectrumLayer.draw(g, responseArea);
+    
+    
+    // Response curve
+    // stroked into its layer only when the parameters, the size or the scale change,
+    // stroking every paint allocated a new outline and edge table each time
+    if (curveLayer.prepare(responseArea, scale) || curveLayerDirty)
+    {
+        renderCurveLayer();
+        curveLayerDirty = false;
+    }
+    
+    curveLayer.draw(g, responseArea);
+    
+    if (showFrameStats)
+    {
+        // text layout allocates, so the overlay is only redone when the stats change, once a second
+        auto statsArea = getLocalBounds().reduced(6, 2).removeFromTop(28);
+        
+        if (statsLayer.prepare(statsArea, scale) || frameScheduler.getStats().window != frameStatsWindow)
+        {
+            renderStatsLayer(statsArea);
+            frameStatsWindow = frameScheduler.getStats().window;
+        }
+        
+        statsLayer.draw(g, statsArea);
+    }
+    
+    frameScheduler.paintFinished();
     
     
     
@@ -375,7 +588,19 @@ peakQualityAttachment(audioProcessor.apvts, "Peak Quality", peakQualitySlider),
 lowCutFreqAttachment(audioProcessor.apvts, "LowCut Freq", lowCutFreqSlider),
 highCutFreqAttachment(audioProcessor.apvts, "HighCut Freq", highCutFreqSlider),
 lowCutSlopeAttachment(audioProcessor.apvts, "LowCut Slope", lowCutSlopeSlider),
-highCutSlopeAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider)
+highCutSlopeAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider),
+peakThresholdAttachment(audioProcessor.apvts, "Peak Threshold", peakThresholdSlider),
+peakRatioAttachment(audioProcessor.apvts, "Peak Ratio", peakRatioSlider),
+peakAttackAttachment(audioProcessor.apvts, "Peak Attack", peakAttackSlider),
+peakReleaseAttachment(audioProcessor.apvts, "Peak Release", peakReleaseSlider),
+sideLowCutFreqAttachment(audioProcessor.apvts, "Side LowCut Freq", sideLowCutFreqSlider),
+sideHighCutFreqAttachment(audioProcessor.apvts, "Side HighCut Freq", sideHighCutFreqSlider),
+sidePeakFreqAttachment(audioProcessor.apvts, "Side Peak Freq", sidePeakFreqSlider),
+sidePeakGainAttachment(audioProcessor.apvts, "Side Peak Gain", sidePeakGainSlider),
+sidePeakQualityAttachment(audioProcessor.apvts, "Side Peak Quality", sidePeakQualitySlider),
+peakDynamicAttachment(audioProcessor.apvts, "Peak Dynamic", peakDynamicButton),
+peakSidechainAttachment(audioProcessor.apvts, "Peak Sidechain", peakSidechainButton),
+midSideAttachment(audioProcessor.apvts, "Mid Side", midSideButton)
 
 {
     for (auto* comp : getComps() )
@@ -411,10 +636,99 @@ highCutSlopeAttachment(audioProcessor.apvts, "HighCut Slope", highCutSlopeSlider
     Mix.addListener(this);
     
     
+    // Analyzer
+    addAndMakeVisible(&analyzerViewChoice);
+    analyzerViewChoice.addItem("L / R", AnalyzerView::LeftRightView + 1);
+    analyzerViewChoice.addItem("M / S", AnalyzerView::MidSideView + 1);
+    analyzerViewChoice.addItem("Sum", AnalyzerView::SumView + 1);
+    analyzerViewChoice.setSelectedId(AnalyzerView::LeftRightView + 1);
+    analyzerViewChoice.addListener(this);
+    
+    addAndMakeVisible(&fftOrderChoice);
+    for( int order = FFTPlanBank::minOrder; order <= FFTPlanBank::maxOrder; ++order )
+        fftOrderChoice.addItem(juce::String(1 << order), order);
+    fftOrderChoice.setSelectedId(FFTOrder::order8192);
+    fftOrderChoice.addListener(this);
+    
+    addAndMakeVisible(&fftWindowChoice);
+    fftWindowChoice.addItem("Hamming", AnalyzerWindow::HammingWindow + 1);
+    fftWindowChoice.addItem("Hann", AnalyzerWindow::HannWindow + 1);
+    fftWindowChoice.addItem("Blackman-Harris", AnalyzerWindow::BlackmanHarrisWindow + 1);
+    fftWindowChoice.addItem("Flat Top", AnalyzerWindow::FlatTopWindow + 1);
+    fftWindowChoice.addItem("Kaiser", AnalyzerWindow::KaiserWindow + 1);
+    fftWindowChoice.setSelectedId(AnalyzerWindow::HammingWindow + 1);
+    fftWindowChoice.addListener(this);
+    
+    addAndMakeVisible(&recordSpectrumButton);
+    recordSpectrumButton.setClickingTogglesState(true);
+    recordSpectrumButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
+    recordSpectrumButton.addListener(this);
+    
+    addAndMakeVisible(&programChoice);
+    for( int i = 0; i < audioProcessor.getNumPrograms(); ++i )
+        programChoice.addItem(audioProcessor.getProgramName(i), i + 1);
+    programChoice.setSelectedId(audioProcessor.getCurrentProgram() + 1, juce::dontSendNotification);
+    programChoice.addListener(this);
+    
+    for( auto* button : { &compareAButton, &compareBButton } )
+    {
+        addAndMakeVisible(button);
+        button->setClickingTogglesState(true);
+        button->setRadioGroupId(1);
+        button->addListener(this);
+    }
+    (audioProcessor.getCompareSlot() == LAUTEQAudioProcessor::SlotA ? compareAButton : compareBButton)
+        .setToggleState(true, juce::dontSendNotification);
+    
+    addAndMakeVisible(&compareCopyButton);
+    
+    for( auto* button : { &peakDynamicButton, &peakSidechainButton, &midSideButton, &sideEditButton } )
+    {
+        addAndMakeVisible(button);
+        button->setClickingTogglesState(true);
+    }
+    
+    for( auto* slider : { &sideLowCutFreqSlider, &sideHighCutFreqSlider, &sidePeakFreqSlider, &sidePeakGainSlider, &sidePeakQualitySlider } )
+        addChildComponent(slider);
+    
+    midSideButton.addListener(this);
+    sideEditButton.addListener(this);
+    updateSideEditor();
+    
+    addAndMakeVisible(&generatorChoice);
+    generatorChoice.addItemList(audioProcessor.apvts.getParameter("Generator")->getAllValueStrings(), 1);
+    generatorAttachment = std::make_unique<APVTS::ComboBoxAttachment>(audioProcessor.apvts, "Generator", generatorChoice);
+    
+    addAndMakeVisible(&verifyButton);
+    verifyButton.addListener(this);
+    
+    if (Tracing::isAvailable())
+    {
+        addAndMakeVisible(&traceButton);
+        traceButton.setClickingTogglesState(true);
+        traceButton.setColour(juce::TextButton::buttonOnColourId, juce::Colours::red);
+        traceButton.addListener(this);
+        
+        // the trace is global, another editor may start or stop it
+        timerCallback();
+        startTimerHz(4);
+    }
+    
+    addAndMakeVisible(&midiLearnChoice);
+    midiLearnChoice.setTextWhenNothingSelected("MIDI Learn");
+    for( int i = 0; i < LAUTEQAudioProcessor::numStateParameters; ++i )
+        midiLearnChoice.addItem("Learn " + audioProcessor.getStateParameterName(i), i + 1);
+    midiLearnChoice.addSeparator();
+    midiLearnChoice.addItem("Clear MIDI CCs", clearMidiControllersId);
+    midiLearnChoice.addListener(this);
+    compareCopyButton.addListener(this);
+    
 }
 
 LAUTEQAudioProcessorEditor::~LAUTEQAudioProcessorEditor()
 {
+    // a running trace is the whole process's, it goes on until TRACE is switched off in any editor
+    
 //    const auto& params = audioProcessor.getParameters();
 //    for ( auto param : params )
 //    {
@@ -425,6 +739,8 @@ LAUTEQAudioProcessorEditor::~LAUTEQAudioProcessorEditor()
 //==============================================================================
 void LAUTEQAudioProcessorEditor::paint (juce::Graphics& g)
 {
+    // the response curve is opaque and caches its own background, so this only runs
+    // when the editor itself is invalidated, never for analyzer frames
     g.fillAll(Colours::black);
     
     
@@ -446,6 +762,17 @@ void LAUTEQAudioProcessorEditor::resized()
     auto responseArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
     
     responseCurveComponent.setBounds(responseArea);
+    recordSpectrumButton.setBounds(responseArea.getRight() - 48, responseArea.getY() + 4, 40, 18);
+    compareCopyButton.setBounds(recordSpectrumButton.getX() - 48, responseArea.getY() + 4, 40, 18);
+    compareBButton.setBounds(compareCopyButton.getX() - 24, responseArea.getY() + 4, 20, 18);
+    compareAButton.setBounds(compareBButton.getX() - 22, responseArea.getY() + 4, 20, 18);
+    programChoice.setBounds(responseArea.getX() + 4, responseArea.getY() + 4, 140, 18);
+    midiLearnChoice.setBounds(programChoice.getRight() + 4, responseArea.getY() + 4, 140, 18);
+    midSideButton.setBounds(midiLearnChoice.getRight() + 4, responseArea.getY() + 4, 36, 18);
+    sideEditButton.setBounds(midSideButton.getRight() + 4, responseArea.getY() + 4, 40, 18);
+    generatorChoice.setBounds(sideEditButton.getRight() + 4, responseArea.getY() + 4, 80, 18);
+    verifyButton.setBounds(responseArea.getRight() - 56, responseArea.getBottom() - 22, 52, 18);
+    traceButton.setBounds(verifyButton.getX() - 56, responseArea.getBottom() - 22, 52, 18);
 
     auto lowCutArea = bounds.removeFromLeft(bounds.getWidth() * 0.33);
     auto highCutArea = bounds.removeFromRight(bounds.getWidth() * 0.5);
@@ -456,13 +783,34 @@ void LAUTEQAudioProcessorEditor::resized()
     highCutFreqSlider.setBounds(highCutArea.removeFromTop(highCutArea.getHeight() * 0.5));
     //highCutSlopeSlider.setBounds(highCutArea);
 
+    // dynamic peak band below the peak controls
+    auto dynamicArea = bounds.removeFromBottom(bounds.getHeight() * 0.3);
+    auto dynamicButtons = dynamicArea.removeFromTop(18);
+    peakDynamicButton.setBounds(dynamicButtons.removeFromLeft(dynamicButtons.getWidth() / 2).reduced(2, 0));
+    peakSidechainButton.setBounds(dynamicButtons.reduced(2, 0));
+    
+    auto dynamicSliderWidth = dynamicArea.getWidth() / 4;
+    peakThresholdSlider.setBounds(dynamicArea.removeFromLeft(dynamicSliderWidth));
+    peakRatioSlider.setBounds(dynamicArea.removeFromLeft(dynamicSliderWidth));
+    peakAttackSlider.setBounds(dynamicArea.removeFromLeft(dynamicSliderWidth));
+    peakReleaseSlider.setBounds(dynamicArea);
+    
     peakFreqSlider.setBounds(bounds.removeFromTop(bounds.getHeight()* 0.33));
     peakGainSlider.setBounds(bounds.removeFromTop(bounds.getHeight()* 0.5));
     peakQualitySlider.setBounds(bounds);
     
+    sideLowCutFreqSlider.setBounds(lowCutFreqSlider.getBounds());
+    sideHighCutFreqSlider.setBounds(highCutFreqSlider.getBounds());
+    sidePeakFreqSlider.setBounds(peakFreqSlider.getBounds());
+    sidePeakGainSlider.setBounds(peakGainSlider.getBounds());
+    sidePeakQualitySlider.setBounds(peakQualitySlider.getBounds());
+    
     
     //dist
     disChoice.setBounds(lowCutArea.removeFromBottom(lowCutArea.getHeight() * 0.5));
+    analyzerViewChoice.setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.33));
+    fftOrderChoice.setBounds(lowCutArea.removeFromTop(lowCutArea.getHeight() * 0.5));
+    fftWindowChoice.setBounds(lowCutArea);
     Threshold.setBounds(highCutArea.removeFromTop(highCutArea.getHeight() * 0.5));
     Mix.setBounds(highCutArea);
 }
@@ -486,13 +834,141 @@ std::vector<juce::Component*> LAUTEQAudioProcessorEditor::getComps()
         &highCutFreqSlider,
         &highCutSlopeSlider,
         &lowCutSlopeSlider,
+        &peakThresholdSlider,
+        &peakRatioSlider,
+        &peakAttackSlider,
+        &peakReleaseSlider,
         &responseCurveComponent,
     };
 }
 
 void LAUTEQAudioProcessorEditor::comboBoxChanged(juce::ComboBox * comboBoxThatHasChanged)
 {
-    audioProcessor.menuChoice = comboBoxThatHasChanged->getSelectedId();
+    if (&disChoice == comboBoxThatHasChanged)
+    {
+        audioProcessor.menuChoice = comboBoxThatHasChanged->getSelectedId();
+    }
+    if (&analyzerViewChoice == comboBoxThatHasChanged)
+    {
+        responseCurveComponent.setAnalyzerView(static_cast<AnalyzerView>(comboBoxThatHasChanged->getSelectedId() - 1));
+    }
+    if (&fftOrderChoice == comboBoxThatHasChanged)
+    {
+        responseCurveComponent.setAnalyzerOrder(static_cast<FFTOrder>(comboBoxThatHasChanged->getSelectedId()));
+    }
+    if (&fftWindowChoice == comboBoxThatHasChanged)
+    {
+        responseCurveComponent.setAnalyzerWindow(static_cast<AnalyzerWindow>(comboBoxThatHasChanged->getSelectedId() - 1));
+    }
+    if (&programChoice == comboBoxThatHasChanged)
+    {
+        audioProcessor.setCurrentProgram(comboBoxThatHasChanged->getSelectedId() - 1);
+    }
+    if (&midiLearnChoice == comboBoxThatHasChanged && comboBoxThatHasChanged->getSelectedId() != 0)
+    {
+        if (comboBoxThatHasChanged->getSelectedId() == clearMidiControllersId)
+            audioProcessor.clearMidiControllers();
+        else
+            audioProcessor.learnMidiController(comboBoxThatHasChanged->getSelectedId() - 1);
+        
+        // back to the prompt, so the same entry can be picked again
+        comboBoxThatHasChanged->setSelectedId(0, juce::dontSendNotification);
+    }
+}
+
+
+void LAUTEQAudioProcessorEditor::buttonClicked(juce::Button * buttonThatWasClicked)
+{
+    if (&recordSpectrumButton == buttonThatWasClicked)
+    {
+        if (recordSpectrumButton.getToggleState())
+        {
+            auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                            .getChildFile("LAUT EQ")
+                            .getChildFile("Spectrum " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".lspec");
+            
+            if (! responseCurveComponent.startSpectrumRecording(file))
+                recordSpectrumButton.setToggleState(false, juce::dontSendNotification);
+        }
+        else
+        {
+            responseCurveComponent.stopSpectrumRecording();
+        }
+    }
+    if (&compareAButton == buttonThatWasClicked && compareAButton.getToggleState())
+    {
+        audioProcessor.selectCompareSlot(LAUTEQAudioProcessor::SlotA);
+    }
+    if (&compareBButton == buttonThatWasClicked && compareBButton.getToggleState())
+    {
+        audioProcessor.selectCompareSlot(LAUTEQAudioProcessor::SlotB);
+    }
+    if (&compareCopyButton == buttonThatWasClicked)
+    {
+        audioProcessor.copyToOtherCompareSlot();
+    }
+    if (&midSideButton == buttonThatWasClicked || &sideEditButton == buttonThatWasClicked)
+    {
+        updateSideEditor();
+    }
+    if (&verifyButton == buttonThatWasClicked)
+    {
+        // the state is copied here, the probe runs on the pool and the result comes back as a message
+        juce::MemoryBlock state;
+        audioProcessor.getStateInformation(state);
+        auto sampleRate = audioProcessor.getSampleRate() > 0 ? audioProcessor.getSampleRate() : 48000.0;
+        
+        verifyButton.setEnabled(false);
+        
+        verifyPool.addJob([state, sampleRate, editor = juce::Component::SafePointer<LAUTEQAudioProcessorEditor>(this)]
+        {
+            auto check = ResponseVerifier::run(state, sampleRate);
+            
+            juce::MessageManager::callAsync([check, editor]
+            {
+                if (editor == nullptr)
+                    return;
+                
+                editor->verifyButton.setEnabled(true);
+                juce::AlertWindow::showMessageBoxAsync(check.passed ? juce::AlertWindow::InfoIcon : juce::AlertWindow::WarningIcon,
+                                                       "Response check", check.describe());
+            });
+        });
+    }
+    if (&traceButton == buttonThatWasClicked)
+    {
+        if (traceButton.getToggleState())
+        {
+            auto file = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory)
+                            .getChildFile("LAUT EQ")
+                            .getChildFile("Trace " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + ".json");
+            
+            if (! Tracing::start(file))
+                traceButton.setToggleState(false, juce::dontSendNotification);
+        }
+        else
+        {
+            Tracing::stop();
+        }
+    }
+}
+
+void LAUTEQAudioProcessorEditor::timerCallback()
+{
+    traceButton.setToggleState(Tracing::isRunning(), juce::dontSendNotification);
+}
+
+void LAUTEQAudioProcessorEditor::updateSideEditor()
+{
+    // the side sliders only make sense in mid/side
+    sideEditButton.setEnabled(midSideButton.getToggleState());
+    auto showSide = midSideButton.getToggleState() && sideEditButton.getToggleState();
+    
+    for( auto* slider : { &lowCutFreqSlider, &highCutFreqSlider, &peakFreqSlider, &peakGainSlider, &peakQualitySlider } )
+        slider->setVisible(! showSide);
+    
+    for( auto* slider : { &sideLowCutFreqSlider, &sideHighCutFreqSlider, &sidePeakFreqSlider, &sidePeakGainSlider, &sidePeakQualitySlider } )
+        slider->setVisible(showSide);
 }
 
 
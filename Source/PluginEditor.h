@@ -10,6 +10,10 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "SIMDKernels.h"
+#include "SpectrumRecorder.h"
+#include "AllocationCounter.h"
+#include "Tracing.h"
 #include <array>
 //==============================================================================//==============================================================================
 //// FFT Data Generator
@@ -20,107 +24,321 @@ enum FFTOrder
     order1024 = 10,
     order2048 = 11,
     order4096 = 12,
-    order8192 = 13
+    order8192 = 13,
+    order16384 = 14
+};
+
+enum AnalyzerWindow
+{
+    HammingWindow,
+    HannWindow,
+    BlackmanHarrisWindow,
+    FlatTopWindow,
+    KaiserWindow,
+    numAnalyzerWindows
+};
+
+//==============================================================================
+/*
+ FFT plans and window tables for every order and window the analyzer offers.
+ 
+ They are built once when the first editor opens and shared by every editor in the
+ process through a SharedResourcePointer, so switching order or window at runtime is
+ just picking another pointer. The tables are normalised to a mean of 1 (coherent gain
+ correction), so a full scale sine reads 0 dB whichever window is selected.
+ */
+struct FFTPlanBank
+{
+    static constexpr int minOrder = FFTOrder::order1024;
+    static constexpr int maxOrder = FFTOrder::order16384;
+    static constexpr int numOrders = maxOrder - minOrder + 1;
+    static constexpr int maxFFTSize = 1 << maxOrder;
+    
+    FFTPlanBank()
+    {
+        using Window = juce::dsp::WindowingFunction<float>;
+        
+        for( int i = 0; i < numOrders; ++i )
+        {
+            auto order = minOrder + i;
+            auto fftSize = (size_t) 1 << order;
+            
+            ffts[i] = std::make_unique<juce::dsp::FFT>(order);
+            
+            for( int w = 0; w < numAnalyzerWindows; ++w )
+            {
+                auto& table = windows[i][w];
+                table.resize(fftSize);
+                Window::fillWindowingTables(table.data(), fftSize, getWindowingMethod(static_cast<AnalyzerWindow>(w)),
+                                            true,   //normalise, i.e. coherent gain of 1
+                                            kaiserBeta);
+            }
+        }
+    }
+    
+    const juce::dsp::FFT* getFFT(FFTOrder order) const { return ffts[order - minOrder].get(); }
+    const float* getWindow(FFTOrder order, AnalyzerWindow window) const { return windows[order - minOrder][window].data(); }
+    
+private:
+    static constexpr float kaiserBeta = 9.f;
+    
+    static juce::dsp::WindowingFunction<float>::WindowingMethod getWindowingMethod(AnalyzerWindow window)
+    {
+        using Window = juce::dsp::WindowingFunction<float>;
+        
+        switch( window )
+        {
+            case HannWindow:            return Window::hann;
+            case BlackmanHarrisWindow:  return Window::blackmanHarris;
+            case FlatTopWindow:         return Window::flatTop;
+            case KaiserWindow:          return Window::kaiser;
+            case HammingWindow:
+            case numAnalyzerWindows:    break;
+        }
+        
+        return Window::hamming;
+    }
+    
+    std::array<std::unique_ptr<juce::dsp::FFT>, numOrders> ffts;
+    std::array<std::array<std::vector<float>, numAnalyzerWindows>, numOrders> windows;
+};
+
+// What the two analyzer traces show. All views come out of the same transform.
+enum AnalyzerView
+{
+    LeftRightView,
+    MidSideView,
+    SumView
+};
+
+// What the analyzer holds per editor, see PathProducer::getMemoryUsage
+struct AnalyzerMemoryReport
+{
+    size_t sampleFifos = 0;         // processor side, audio blocks on their way to the editor
+    int sampleFifoBlocks = 0;       // blocks each of them holds
+    size_t spectrumFifos = 0;
+    size_t pathFifos = 0;
+    size_t workingBuffers = 0;      // history, transform and current frame, sized for the largest order
+    
+    size_t getFifoTotal() const { return sampleFifos + spectrumFifos + pathFifos; }
+    size_t getTotal() const { return getFifoTotal() + workingBuffers; }
 };
 
 template<typename BlockType>
 struct FFTDataGenerator
 {
+    // Frames wait in the fifos as 16 bit dB between the floor and ceilingDecibels, steps of
+    // about 0.001 dB, far finer than a pixel, at half the size of a float. Only the newest
+    // frame waits for its path, see PathProducer::process, so a fifo holds one.
+    static constexpr int fifoCapacity = 1;
+    static constexpr float ceilingDecibels = 24.f;
+    
+    using QuantizedFrame = std::vector<uint16_t>;
+    
+    // everything is sized for the largest order up front, so changeOrder never allocates
+    FFTDataGenerator()
+    {
+        pulledFrame.reserve(FFTPlanBank::maxFFTSize / 2);
+        
+        for( int trace = 0; trace < 2; ++trace )
+        {
+            fftData[trace].reserve(FFTPlanBank::maxFFTSize / 2);
+            quantizedFrames[trace].reserve(FFTPlanBank::maxFFTSize / 2);
+            fftDataFifos[trace].prepare(FFTPlanBank::maxFFTSize / 2);
+        }
+        
+        changeOrder(FFTOrder::order8192);
+    }
+    
+    // The transform's input and output, complex and for the largest order, live in the
+    // owner's BufferArena: addToLayout reserves them, prepare(arena) takes them.
+    void addToLayout(ArenaLayout& layout)
+    {
+        timeOffset = layout.addFloats(2 * (size_t) FFTPlanBank::maxFFTSize);
+        freqOffset = layout.addFloats(2 * (size_t) FFTPlanBank::maxFFTSize);
+    }
+    
+    void prepare(BufferArena& arena)
+    {
+        // std::complex<float> is laid out as two floats, arrays of it as arrays of those
+        timeData = reinterpret_cast<Complex*>(arena.getFloats(timeOffset));
+        freqData = reinterpret_cast<Complex*>(arena.getFloats(freqOffset));
+    }
+    
     /**
-     produces the FFT data from an audio buffer.
+     produces the FFT data for both channels from a single complex transform.
+     
+     left goes into the real part and right into the imaginary part, and the two
+     spectra are separated again using the conjugate symmetry of real signals:
+        L[k] = (Z[k] + conj(Z[N-k])) / 2
+        R[k] = (Z[k] - conj(Z[N-k])) / 2j
+     mid, side and sum are linear combinations of L[k] and R[k], so they come for free.
      */
     // Feed Audio into FFT
-    void produceFFTDataForRendering(const juce::AudioBuffer<float>& audioData, const float negativeInfinity)
+    void produceFFTDataForRendering(const juce::AudioBuffer<float>& leftData,
+                                    const juce::AudioBuffer<float>& rightData,
+                                    const float negativeInfinity)
     {
         const auto fftSize = getFFTSize(); // Order
+        jassert( timeData != nullptr );
+        
+        // window the most recent fftSize samples of both channels straight into the complex input
+        auto numToCopy = juce::jmin(fftSize, leftData.getNumSamples(), rightData.getNumSamples());
+        auto* left = leftData.getReadPointer(0, leftData.getNumSamples() - numToCopy);
+        auto* right = rightData.getReadPointer(0, rightData.getNumSamples() - numToCopy);
         
-        fftData.assign(fftData.size(), 0);
-        auto* readIndex = audioData.getReadPointer(0);
-        std::copy(readIndex, readIndex + fftSize, fftData.begin());
+        for( int i = 0; i < numToCopy; ++i )
+            timeData[i] = { left[i] * windowTable[i], right[i] * windowTable[i] };
         
-        // first apply a windowing function to our data
-        window->multiplyWithWindowingTable (fftData.data(), fftSize);       // [1]
+        std::fill(timeData + numToCopy, timeData + fftSize, Complex());
         
-        // then render our FFT data..
-        forwardFFT->performFrequencyOnlyForwardTransform (fftData.data());  // [2]
+        // one transform for both channels
+        forwardFFT->perform(timeData, freqData, false);
         
         int numBins = (int)fftSize / 2;
+        auto* first = fftData[0].data();
+        auto* second = fftData[1].data();
         
-        //normalize the fft values.
-        for( int i = 0; i < numBins; ++i )
+        auto magnitude = [](const Complex& c) { return std::sqrt(std::norm(c)); };
+        
+        for( int k = 0; k < numBins; ++k )
         {
-            auto v = fftData[i];
-            //            fftData[i] /= (float) numBins;
-            if( !std::isinf(v) && !std::isnan(v) )
-            {
-                v /= float(numBins);
-            }
-            else
+            auto z = freqData[k];
+            auto zc = std::conj(freqData[(fftSize - k) & (fftSize - 1)]);
+            
+            auto l = (z + zc) * 0.5f;
+            auto r = (z - zc) * Complex(0.f, -0.5f);
+            
+            switch( view )
             {
-                v = 0.f;
+                case LeftRightView:
+                    first[k] = magnitude(l);
+                    second[k] = magnitude(r);
+                    break;
+                case MidSideView:
+                    first[k] = magnitude((l + r) * 0.5f);
+                    second[k] = magnitude((l - r) * 0.5f);
+                    break;
+                case SumView:
+                    first[k] = magnitude(l + r);
+                    break;
             }
-            fftData[i] = v;
         }
         
-        //convert them to decibels
-        for( int i = 0; i < numBins; ++i )
+        //normalize the fft values and convert them to decibels in one pass
+        lastFrameSilent = true;
+        floorDecibels = negativeInfinity;
+        
+        for( int trace = 0; trace < getNumTraces(); ++trace )
         {
-            fftData[i] = juce::Decibels::gainToDecibels(fftData[i], negativeInfinity);
+            SIMDKernels::gainToDecibels(fftData[trace].data(), numBins, 1.f / float(numBins), negativeInfinity);
+            
+            auto& quantized = quantizedFrames[trace];
+            quantized.resize((size_t) numBins);     // within the reserved capacity
+            
+            auto scale = 65535.f / (ceilingDecibels - floorDecibels);
+            for( int k = 0; k < numBins; ++k )
+            {
+                auto level = juce::jlimit(floorDecibels, ceilingDecibels, fftData[trace][k]);
+                quantized[k] = (uint16_t) ((level - floorDecibels) * scale + 0.5f);
+            }
+            
+            fftDataFifos[trace].push(quantized);
+            
+            if( juce::FloatVectorOperations::findMaximum(fftData[trace].data(), numBins) > negativeInfinity )
+                lastFrameSilent = false;
         }
-        
-        
-        
-        
-        fftDataFifo.push(fftData);
     }
     
+    // plans, windows and buffers all exist already, so switching is a pointer swap
     void changeOrder(FFTOrder newOrder)
     {
-        //when you change order, recreate the window, forwardFFT, fifo, fftData
-        //also reset the fifoIndex
-        //things that need recreating should be created on the heap via std::make_unique<>
-        
         order = newOrder;
-        auto fftSize = getFFTSize();
-        
-        forwardFFT = std::make_unique<juce::dsp::FFT>(order);
-        window = std::make_unique<juce::dsp::WindowingFunction<float>>(fftSize, juce::dsp::WindowingFunction<float>::hamming);
-        
-//        enum WindowingMethod
-//        {
-//            rectangular = 0,
-//            triangular,
-//            hann,
-//            hamming,
-//            blackman,
-//            blackmanHarris,
-//            flatTop,
-//            kaiser,
-//            numWindowingMethods
-//        };
-        
-        fftData.clear();
-        fftData.resize(fftSize * 2, 0);
-        
-        fftDataFifo.prepare(fftData.size());
+        forwardFFT = plans->getFFT(order);
+        windowTable = plans->getWindow(order, window);
+        
+        for( auto& data : fftData )
+            data.resize(getFFTSize() / 2, 0);   // stays within the reserved capacity
+    }
+    
+    void changeWindow(AnalyzerWindow newWindow)
+    {
+        window = newWindow;
+        windowTable = plans->getWindow(order, window);
     }
+    
+    // takes effect from the next frame
+    void setView(AnalyzerView newView) { view = newView; }
+    AnalyzerView getView() const { return view; }
+    int getNumTraces() const { return view == SumView ? 1 : 2; }
     //==============================================================================
 
     int getFFTSize() const { return 1 << order; }
-    int getNumAvailableFFTDataBlocks() const { return fftDataFifo.getNumAvailableForReading(); }        // so how much fft data we have available
+    FFTOrder getOrder() const { return order; }
+    bool isLastFrameSilent() const { return lastFrameSilent; }      // every bin at the floor
+    AnalyzerWindow getWindow() const { return window; }
+    int getNumAvailableFFTDataBlocks() const { return fftDataFifos[0].getNumAvailableForReading(); }    // so how much fft data we have available
     //==============================================================================
-    bool getFFTData(BlockType& fftData) { return fftDataFifo.pull(fftData); }                           // get fft data
+    // get fft data, back in dB
+    bool getFFTData(int trace, BlockType& data)
+    {
+        if( ! fftDataFifos[trace].pull(pulledFrame) )
+            return false;
+        
+        data.resize(pulledFrame.size());
+        
+        auto step = (ceilingDecibels - floorDecibels) / 65535.f;
+        for( size_t k = 0; k < pulledFrame.size(); ++k )
+            data[k] = floorDecibels + step * (float) pulledFrame[k];
+        
+        return true;
+    }
+    
+    const BlockType& getLatestFFTData(int trace) const { return fftData[trace]; }                      // last frame, without pulling
+    
+    // frames nobody is going to draw
+    void discardFFTData()
+    {
+        for( auto& fifo : fftDataFifos )
+            fifo.discardAvailable();
+    }
+    
+    void addMemoryUsage(AnalyzerMemoryReport& report) const
+    {
+        for( int trace = 0; trace < 2; ++trace )
+        {
+            report.spectrumFifos += fftDataFifos[trace].getMemoryUsage();
+            report.workingBuffers += fftData[trace].capacity() * sizeof(float)
+                                   + quantizedFrames[trace].capacity() * sizeof(uint16_t);
+        }
+        
+        // the transform buffers are in the owner's arena and counted there
+        report.workingBuffers += pulledFrame.capacity() * sizeof(uint16_t);
+    }
     
     
     // GET
     
 private:
-    FFTOrder order;
-    BlockType fftData;
-    std::unique_ptr<juce::dsp::FFT> forwardFFT;
-    std::unique_ptr<juce::dsp::WindowingFunction<float>> window;
-    
-    Fifo<BlockType> fftDataFifo;
+    using Complex = juce::dsp::Complex<float>;
+    
+    juce::SharedResourcePointer<FFTPlanBank> plans;
+    
+    FFTOrder order = FFTOrder::order8192;
+    AnalyzerWindow window = HammingWindow;
+    AnalyzerView view = LeftRightView;
+    bool lastFrameSilent = true;
+    float floorDecibels = -48.f;
+    std::array<BlockType, 2> fftData;
+    Complex* timeData = nullptr;
+    Complex* freqData = nullptr;
+    size_t timeOffset = 0, freqOffset = 0;
+    const juce::dsp::FFT* forwardFFT = nullptr;
+    const float* windowTable = nullptr;
+    
+    std::array<QuantizedFrame, 2> quantizedFrames;
+    QuantizedFrame pulledFrame;
+    std::array<Fifo<QuantizedFrame, fifoCapacity>, 2> fftDataFifos;
 };
 
 //==============================================================================//==============================================================================
@@ -141,13 +359,17 @@ struct AnalyzerPathGenerator
                       float binWidth,
                       float negativeInfinity)
     {
+        LAUTEQ_TRACE_SCOPE("generatePath");
+        
         auto top = fftBounds.getY();
         auto bottom = fftBounds.getHeight();
         auto width = fftBounds.getWidth();
         
         int numBins = (int)fftSize / 2;
         
-        PathType p;
+        // cleared, not rebuilt: the storage from earlier frames is reused
+        auto& p = path;
+        p.clear();
         p.preallocateSpace(3 * (int)fftBounds.getWidth());
         
         auto map = [bottom, top, negativeInfinity](float v)
@@ -167,6 +389,11 @@ struct AnalyzerPathGenerator
         
         const int pathResolution = 1; //you can draw line-to's every 'pathResolution' pixels.
         
+        // One point per pixel column, the loudest bin in it. Up top hundreds of bins share
+        // a column, a point for each only makes the path bigger, not the picture.
+        int columnX = -1;
+        float columnY = 0;
+        
         for( int binNum = 1; binNum < numBins; binNum += pathResolution )
         {
             y = map(renderData[binNum]);
@@ -178,11 +405,26 @@ struct AnalyzerPathGenerator
                 auto binFreq = binNum * binWidth;
                 auto normalizedBinX = juce::mapFromLog10(binFreq, 20.f, 20000.f);
                 int binX = std::floor(normalizedBinX * width);
-                p.lineTo(binX, y);
+                
+                if( binX == columnX )
+                {
+                    columnY = juce::jmin(columnY, y);
+                    continue;
+                }
+                
+                if( columnX >= 0 )
+                    p.lineTo(columnX, columnY);
+                
+                columnX = binX;
+                columnY = y;
             }
         }
         
-        pathFifo.push(p);
+        if( columnX >= 0 )
+            p.lineTo(columnX, columnY);
+        
+        // p gets the slot's old path back, it is cleared again next time
+        pathFifo.pushBySwapping(p);
     }
     
     int getNumPathsAvailable() const
@@ -191,13 +433,18 @@ struct AnalyzerPathGenerator
     }
     
     // Pull data // path output 
+    // swaps, so 'path' hands its storage to the fifo for a later frame
     bool getPath(PathType& path)
     {
-        return pathFifo.pull(path);
+        return pathFifo.pullBySwapping(path);
     }
     
+    size_t getMemoryUsage() const { return pathFifo.getMemoryUsage(); }
+    
 private:
-    Fifo<PathType> pathFifo;
+    // a path is pulled right after it is made, in the same timer callback
+    Fifo<PathType, 1> pathFifo;
+    PathType path;
 };
 
 //==============================================================================SLIDER //==============================================================================
@@ -220,40 +467,237 @@ struct PathProducer
 {
     // Constructor for..
     
-    PathProducer(SingleChannelSampleFifo<LAUTEQAudioProcessor::BlockType>& scsf) :
-    leftChannelFifo(&scsf)
+    PathProducer(LAUTEQAudioProcessor::AnalyzerFifo& leftScsf,
+                 LAUTEQAudioProcessor::AnalyzerFifo& rightScsf) :
+    leftChannelFifo(&leftScsf),
+    rightChannelFifo(&rightScsf)
     {
-        leftChannelFFTDataGenerator.changeOrder(FFTOrder::order8192);
-        monoBuffer.setSize(1, leftChannelFFTDataGenerator.getFFTSize());
+        // history for the largest order, smaller orders use the most recent part of it, and
+        // scratch the same size as the fifo's blocks, so pulling one copies without reallocating
+        ArenaLayout layout;
+        auto leftOffset = layout.addFloats((size_t) FFTPlanBank::maxFFTSize);
+        auto rightOffset = layout.addFloats((size_t) FFTPlanBank::maxFFTSize);
+        auto incomingOffset = layout.addFloats((size_t) LAUTEQAudioProcessor::analyzerBlockSize);
+        fftDataGenerator.addToLayout(layout);
+        
+        arena.prepare(layout);
+        
+        auto referTo = [this](juce::AudioBuffer<float>& buffer, size_t offset, int numSamples)
+        {
+            float* channel[] { arena.getFloats(offset) };
+            buffer.setDataToReferTo(channel, 1, numSamples);
+        };
+        
+        referTo(leftMonoBuffer, leftOffset, FFTPlanBank::maxFFTSize);
+        referTo(rightMonoBuffer, rightOffset, FFTPlanBank::maxFFTSize);
+        referTo(tempIncomingBuffer, incomingOffset, LAUTEQAudioProcessor::analyzerBlockSize);
+        fftDataGenerator.prepare(arena);
+        
+        fftFrame.reserve(FFTPlanBank::maxFFTSize / 2);
     }
     
     
     // give rectangle , sample rate
-    void process(juce::Rectangle<float> fftBounds, double sampleRate);
+    // returns false when nothing new needs drawing, e.g. the input stayed silent
+    bool process(juce::Rectangle<float> fftBounds, double sampleRate);
+    
+    void setView(AnalyzerView newView);
+    void setOrder(FFTOrder newOrder) { fftDataGenerator.changeOrder(newOrder); }
+    void setWindow(AnalyzerWindow newWindow) { fftDataGenerator.changeWindow(newWindow); }
     
+    // every produced frame is also handed to the recorder while it is recording
+    void setRecorder(SpectrumRecorder* newRecorder) { recorder = newRecorder; }
     
-    juce::Path getPath() {return leftChannelFFTPath; }
+    int getNumPaths() const { return fftDataGenerator.getNumTraces(); }
+    const juce::Path& getPath(int index) const { return fftPaths[index]; }
+    
+    // swaps instead of copying: the newest path goes to 'destination', and its old storage
+    // comes back here to be refilled by a later frame
+    void takePath(int index, juce::Path& destination) { fftPaths[index].swapWithPath(destination); }
+    
+    AnalyzerMemoryReport getMemoryUsage() const;
     
     private:
     
     // Pointer to Audio Process Channels 
-    SingleChannelSampleFifo<LAUTEQAudioProcessor::BlockType>* leftChannelFifo;
+    LAUTEQAudioProcessor::AnalyzerFifo* leftChannelFifo;
+    LAUTEQAudioProcessor::AnalyzerFifo* rightChannelFifo;
+    
     
+    // The buffers every frame streams through: the histories, the incoming block and the
+    // transform's input and output, about 390 KB in one aligned block. What stays out has
+    // a reason to: the spectrum frames and the fifos' slots are vectors that change size
+    // with the order and are copied into, the paths are juce::Paths that manage their own
+    // storage, and none of them is touched sample by sample like these are.
+    BufferArena arena;
     
-    // Monobuffer because single channel is mono for FFT
-    juce::AudioBuffer<float> monoBuffer;
+    // one history buffer per channel, both go into the same transform
+    juce::AudioBuffer<float> leftMonoBuffer, rightMonoBuffer;
+    
+    // scratch for process(), kept so a frame doesn't allocate them again
+    juce::AudioBuffer<float> tempIncomingBuffer;
+    std::vector<float> fftFrame;
     
     // Instance of the class
-    FFTDataGenerator<std::vector<float>> leftChannelFFTDataGenerator;
+    FFTDataGenerator<std::vector<float>> fftDataGenerator;
+    
+    // pathProducer in Path Generator, one per trace
+    std::array<AnalyzerPathGenerator<juce::Path>, 2> pathProducers;
+    
+    // paths to draw and pull into 
+    std::array<juce::Path, 2> fftPaths;
+    
+    bool previousFrameSilent = true;
+    
+    SpectrumRecorder* recorder = nullptr;
+};
+
+
+//============================================================================== FRAME SCHEDULER //==============================================================================
+/*
+ Paces the analyzer repaints.
+ 
+ While there is something new to show (a fresh analyzer frame or a parameter change)
+ the timer runs at the frame rate cap and every tick repaints. Once nothing has changed
+ for idleAfterTicks ticks, e.g. because the input is silent, it drops to idleFrameRate
+ and stops repainting until new content arrives.
+ 
+ It also measures what was actually achieved: frames per second and the time spent in
+ paint, averaged over one second windows. With LAUTEQ_COUNT_ALLOCATIONS it counts the
+ message thread's heap allocations from one frame to the next as well, everything the
+ analyzer and paint did in between. The analyzer itself makes none once it is running,
+ what's left is juce's renderer stroking a new spectrum frame into its layer.
+ */
+struct FrameScheduler
+{
+    struct Stats
+    {
+        double framesPerSecond = 0;
+        double averagePaintMs = 0;
+        double maxPaintMs = 0;
+        double averageAllocations = 0;      // per frame, only with AllocationCounter::isEnabled()
+        uint64_t maxAllocations = 0;
+        int window = 0;                     // counts up every time the stats are updated
+    };
+    
+    void setMaxFrameRate(int newFrameRate) { maxFrameRate = juce::jlimit(idleFrameRate, 240, newFrameRate); }
+    int getMaxFrameRate() const { return maxFrameRate; }
+    
+    // call once per tick, returns true if this tick should repaint
+    bool tick(bool hasNewContent)
+    {
+        idleTicks = hasNewContent ? 0 : idleTicks + 1;
+        return hasNewContent;
+    }
+    
+    int getTimerHz() const { return idleTicks > idleAfterTicks ? idleFrameRate : maxFrameRate; }
+    
+    void paintStarted() { paintStartTicks = juce::Time::getHighResolutionTicks(); }
+    
+    void paintFinished()
+    {
+        auto now = juce::Time::getHighResolutionTicks();
+        auto paintSeconds = juce::Time::highResolutionTicksToSeconds(now - paintStartTicks);
+        
+        if( framesInWindow == 0 )
+            windowStartTicks = paintStartTicks;
+        
+        ++framesInWindow;
+        paintSecondsInWindow += paintSeconds;
+        maxPaintSecondsInWindow = juce::jmax(maxPaintSecondsInWindow, paintSeconds);
+        
+        auto allocations = AllocationCounter::getNumAllocations();
+        auto frameAllocations = allocations - lastFrameAllocations;
+        lastFrameAllocations = allocations;
+        allocationsInWindow += frameAllocations;
+        maxAllocationsInWindow = juce::jmax(maxAllocationsInWindow, frameAllocations);
+        
+        auto windowSeconds = juce::Time::highResolutionTicksToSeconds(now - windowStartTicks);
+        if( windowSeconds >= 1.0 )
+        {
+            stats.framesPerSecond = framesInWindow / windowSeconds;
+            stats.averagePaintMs = 1000.0 * paintSecondsInWindow / framesInWindow;
+            stats.maxPaintMs = 1000.0 * maxPaintSecondsInWindow;
+            stats.averageAllocations = double(allocationsInWindow) / framesInWindow;
+            stats.maxAllocations = maxAllocationsInWindow;
+            ++stats.window;
+            
+            framesInWindow = 0;
+            paintSecondsInWindow = 0;
+            maxPaintSecondsInWindow = 0;
+            allocationsInWindow = 0;
+            maxAllocationsInWindow = 0;
+        }
+    }
     
-    // pathProducer in Path Generator
-    AnalyzerPathGenerator<juce::Path> pathProducer;
+    const Stats& getStats() const { return stats; }
     
-    // path to draw and pull into 
-    juce::Path leftChannelFFTPath;
+private:
+    static constexpr int idleFrameRate = 10;
+    static constexpr int idleAfterTicks = 30;
+    
+    int maxFrameRate = 60;
+    int idleTicks = 0;
+    
+    juce::int64 paintStartTicks = 0, windowStartTicks = 0;
+    int framesInWindow = 0;
+    double paintSecondsInWindow = 0, maxPaintSecondsInWindow = 0;
+    uint64_t lastFrameAllocations = 0, allocationsInWindow = 0, maxAllocationsInWindow = 0;
+    Stats stats;
 };
 
 
+//============================================================================== LAYER CACHE //==============================================================================
+/*
+ Offscreen image for one layer of a component, kept at the physical pixel density it
+ was last painted at so it blits 1:1 on hi-dpi displays.
+ */
+struct LayerCache
+{
+    // returns true if the image had to be recreated, its content has to be rendered again then
+    bool prepare(juce::Rectangle<int> bounds, float scale)
+    {
+        auto width = juce::jmax(1, juce::roundToInt(bounds.getWidth() * scale));
+        auto height = juce::jmax(1, juce::roundToInt(bounds.getHeight() * scale));
+        
+        if( image.isValid() && image.getWidth() == width && image.getHeight() == height && scale == imageScale )
+            return false;
+        
+        image = juce::Image(juce::Image::ARGB, width, height, true);
+        imageScale = scale;
+        return true;
+    }
+    
+    // clears the layer and hands out a Graphics that draws in component coordinates
+    template<typename RenderFunction>
+    void render(RenderFunction&& renderFunction)
+    {
+        image.clear(image.getBounds());
+        
+        juce::Graphics lg(image);
+        lg.addTransform(juce::AffineTransform::scale(imageScale));
+        renderFunction(lg);
+    }
+    
+    void draw(juce::Graphics& g, juce::Rectangle<int> bounds) const
+    {
+        g.drawImage(image, bounds.toFloat());
+    }
+    
+private:
+    juce::Image image;
+    float imageScale = 1.f;
+};
+
+// How much of the analyzer history gets drawn into the spectrum layer
+struct SpectrumLayerSettings
+{
+    int numTrails = 3;          // frames drawn per trace, newest first, 1 means no trails
+    float strokeWidth = 1.f;
+};
+
+static constexpr int maxSpectrumTrails = 8;
+
 //============================================================================== RESPONSE CURVE //==============================================================================
 
 struct ResponseCurveComponent : juce::Component,
@@ -272,6 +716,25 @@ juce::Timer
     
     void paint(juce::Graphics& g) override;
     
+    void resized() override;
+    
+    // toggles the frame rate / paint cost overlay
+    void mouseDoubleClick(const juce::MouseEvent&) override { showFrameStats = ! showFrameStats; repaint(); }
+    
+    // repaint rate cap while the analyzer is moving, the display refresh rate is a good choice
+    void setMaxFrameRate(int newFrameRate) { frameScheduler.setMaxFrameRate(newFrameRate); }
+    const FrameScheduler::Stats& getFrameStats() const { return frameScheduler.getStats(); }
+    
+    void setSpectrumLayerSettings(SpectrumLayerSettings newSettings);
+    
+    void setAnalyzerView(AnalyzerView newView) { pathProducer.setView(newView); repaint(); }
+    void setAnalyzerOrder(FFTOrder newOrder) { pathProducer.setOrder(newOrder); }
+    void setAnalyzerWindow(AnalyzerWindow newWindow) { pathProducer.setWindow(newWindow); }
+    
+    // streams the analyzer frames to 'file', see SpectrumRecorder
+    bool startSpectrumRecording(const juce::File& file) { return spectrumRecorder.start(file); }
+    void stopSpectrumRecording() { spectrumRecorder.stop(); }
+    
     
 //    
 //    juce::Array<float> getHistory()
@@ -284,7 +747,22 @@ private:
         juce::Atomic<bool> parametersChanged { false };
         void updateChain();
     
-        MonoChain monoChain;
+        EQDesign responseDesign;        // same bands as the processor, only read for the curve
+    
+    // response curve cache, rebuilt only when the parameters, size or sample rate change
+    void updateColumnTables();
+    void updateResponseCurve();
+    
+    std::vector<float> columnCos, columnSin, columnCos2, columnSin2;
+    std::vector<float> responseMags;
+    double columnTableSampleRate = 0;
+    juce::Path responseCurve;
+    
+    // the curve stroked once per change, paint only blits it
+    void renderCurveLayer();
+    
+    LayerCache curveLayer;
+    bool curveLayerDirty = true;
     
     juce::Rectangle<int> getRenderArea();
     
@@ -292,8 +770,33 @@ private:
     
     
     
-    // FFT DATA To Path Producer 
-    PathProducer leftPathProducer, rightPathProducer;
+    // FFT DATA To Path Producer, both channels share one transform
+    PathProducer pathProducer;
+    SpectrumRecorder spectrumRecorder;
+    
+    FrameScheduler frameScheduler;
+    bool showFrameStats = false;
+    
+    // the overlay, laid out once per stats window rather than every paint
+    void renderStatsLayer(juce::Rectangle<int> statsArea);
+    
+    LayerCache statsLayer;
+    int frameStatsWindow = -1;
+    
+    // spectrum layer, redrawn once per new analyzer frame and blitted on every paint
+    void pushSpectrumFrame();
+    void renderSpectrumLayer();
+    
+    SpectrumLayerSettings spectrumLayerSettings;
+    std::array<std::array<juce::Path, 2>, maxSpectrumTrails> spectrumTrails;
+    LayerCache spectrumLayer;
+    bool spectrumLayerDirty = true;
+    
+    // background, grid, labels and border, only invalidated by resized() or a new scale factor
+    void renderBackgroundLayer();
+    
+    LayerCache backgroundLayer;
+    bool backgroundLayerDirty = true;
     
     juce::ColourGradient grand;
     
@@ -308,7 +811,9 @@ class LAUTEQAudioProcessorEditor  : public  juce::AudioProcessorEditor,
                                             
 
                                     private juce::ComboBox::Listener,
-                                            juce::Slider::Listener
+                                            juce::Slider::Listener,
+                                            juce::Button::Listener,
+                                            juce::Timer
 {
 public:
     LAUTEQAudioProcessorEditor (LAUTEQAudioProcessor&);
@@ -335,7 +840,16 @@ private:
                         lowCutFreqSlider,
                         highCutFreqSlider,
                         lowCutSlopeSlider,
-                        highCutSlopeSlider;
+                        highCutSlopeSlider,
+                        peakThresholdSlider,
+                        peakRatioSlider,
+                        peakAttackSlider,
+                        peakReleaseSlider,
+                        sideLowCutFreqSlider,
+                        sideHighCutFreqSlider,
+                        sidePeakFreqSlider,
+                        sidePeakGainSlider,
+                        sidePeakQualitySlider;
     
     ResponseCurveComponent responseCurveComponent;
     
@@ -348,7 +862,33 @@ private:
                         lowCutFreqAttachment,
                         highCutFreqAttachment,
                         lowCutSlopeAttachment,
-                        highCutSlopeAttachment;
+                        highCutSlopeAttachment,
+                        peakThresholdAttachment,
+                        peakRatioAttachment,
+                        peakAttackAttachment,
+                        peakReleaseAttachment,
+                        sideLowCutFreqAttachment,
+                        sideHighCutFreqAttachment,
+                        sidePeakFreqAttachment,
+                        sidePeakGainAttachment,
+                        sidePeakQualityAttachment;
+    
+    // dynamic peak band on/off, detector on the sidechain input
+    juce::TextButton peakDynamicButton { "DYN" }, peakSidechainButton { "SC" };
+    APVTS::ButtonAttachment peakDynamicAttachment, peakSidechainAttachment;
+    
+    // mid/side mode, SIDE swaps the side chain's sliders in where the mid ones sit
+    juce::TextButton midSideButton { "M/S" }, sideEditButton { "SIDE" };
+    APVTS::ButtonAttachment midSideAttachment;
+    void updateSideEditor();
+    
+    // test signal in place of the input, attached once its items are in
+    juce::ComboBox generatorChoice;
+    std::unique_ptr<APVTS::ComboBoxAttachment> generatorAttachment;
+    
+    // runs ResponseVerifier on verifyPool and shows how far the audio path is from the curve
+    juce::TextButton verifyButton { "CHECK" };
+    juce::ThreadPool verifyPool { 1 };
 
     
     std::vector<juce::Component*> getComps();
@@ -360,6 +900,26 @@ private:
     void comboBoxChanged(juce::ComboBox* comboBoxThatHasChanged) override;
     juce::ComboBox disChoice;
     
+    // Analyzer
+    juce::ComboBox analyzerViewChoice, fftOrderChoice, fftWindowChoice;
+    
+    // records the analyzer frames to a file in Documents/LAUT EQ
+    void buttonClicked(juce::Button* buttonThatWasClicked) override;
+    juce::TextButton recordSpectrumButton { "REC" };
+    
+    // writes a Chrome trace to Documents/LAUT EQ, only shown in builds with LAUTEQ_TRACING.
+    // The timer keeps it showing Tracing::isRunning(), whichever editor started the trace
+    juce::TextButton traceButton { "TRACE" };
+    void timerCallback() override;
+    
+    // Programs, A/B compare
+    juce::ComboBox programChoice;
+    juce::TextButton compareAButton { "A" }, compareBButton { "B" }, compareCopyButton { "Copy" };
+    
+    // MIDI learn, picks the parameter the next incoming controller is bound to
+    juce::ComboBox midiLearnChoice;
+    static constexpr int clearMidiControllersId = 100;
+    
     void sliderValueChanged(juce::Slider* sliderThatHasChanged) override;
     
     juce::Slider Threshold;
@@ -8,6 +8,98 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "Tracing.h"
+
+//==============================================================================
+// Binary plugin state, version 2, little-endian:
+//
+//    'LEQB'                      4 bytes magic
+//    version                     uint16
+//    numValues                   uint16
+//    numValues x float           plain (denormalised) parameter values, in stateParameterIDs order
+//    128 x int8                  parameter index per MIDI controller, -1 for none (since version 2)
+//
+// New parameters and fields only ever get appended, a blob with fewer values leaves the
+// rest at their defaults. A blob from a newer version is read as far as this one knows,
+// its extra values and anything after the controller map are ignored. Anything without
+// the magic is read as the old ValueTree state.
+
+namespace
+{
+    constexpr int stateMagic = 0x4251454c;      // 'LEQB' as little-endian int
+    constexpr int stateVersion = 2;
+    constexpr int stateHeaderSize = 8;
+    constexpr int numMidiControllers = 128;
+
+    const char* const stateParameterIDs[LAUTEQAudioProcessor::numStateParameters]
+    {
+        "LowCut Freq",
+        "HighCut Freq",
+        "Peak Freq",
+        "Peak Gain",
+        "Peak Quality",
+        "LowCut Slope",
+        "HighCut Slope",
+        "Peak Dynamic",
+        "Peak Threshold",
+        "Peak Ratio",
+        "Peak Attack",
+        "Peak Release",
+        "Peak Sidechain",
+        "Mid Side",
+        "Side LowCut Freq",
+        "Side HighCut Freq",
+        "Side Peak Freq",
+        "Side Peak Gain",
+        "Side Peak Quality",
+        "Side LowCut Slope",
+        "Side HighCut Slope",
+        "Generator",
+        "Generator Freq",
+        "Generator Level"
+    };
+    
+    //==============================================================================
+    // Factory programs
+    
+    struct FactoryProgram
+    {
+        const char* name;
+        ChainSettings settings;
+    };
+    
+    //                                        peak Hz  gain dB  Q       low cut  high cut  low slope  high slope
+    const FactoryProgram factoryPrograms[]
+    {
+        { "Flat",                           { 750.f,   0.f,     1.f,    20.f,    20000.f,  Slope_12,  Slope_12 } },
+        { "Rumble Filter",                  { 750.f,   0.f,     1.f,    60.f,    20000.f,  Slope_24,  Slope_12 } },
+        { "Vocal Presence",                 { 3000.f,  4.f,     0.8f,   100.f,   20000.f,  Slope_12,  Slope_12 } },
+        { "Warmth",                         { 250.f,   3.f,     0.7f,   30.f,    12000.f,  Slope_12,  Slope_12 } },
+        { "De-Mud",                         { 400.f,   -5.f,    1.4f,   40.f,    20000.f,  Slope_12,  Slope_12 } },
+        { "Air",                            { 12000.f, 4.f,     0.5f,   20.f,    20000.f,  Slope_12,  Slope_12 } },
+        { "Telephone",                      { 1500.f,  6.f,     1.f,    400.f,   3400.f,   Slope_48,  Slope_48 } }
+    };
+    
+    constexpr int numFactoryPrograms = (int) (sizeof(factoryPrograms) / sizeof(factoryPrograms[0]));
+    
+    constexpr double crossfadeSeconds = 0.02;
+    
+    // one of the first numChainParameters state parameters, in the order of stateParameterIDs
+    void setChainValue(ChainSettings& settings, int parameterIndex, float value)
+    {
+        switch( parameterIndex )
+        {
+            case 0: settings.lowCutFreq = value; break;
+            case 1: settings.highCutFreq = value; break;
+            case 2: settings.peakFreq = value; break;
+            case 3: settings.peakGainInDecibels = value; break;
+            case 4: settings.peakQuality = value; break;
+            case 5: settings.lowCutSlope = static_cast<Slope>(value); break;
+            case 6: settings.highCutSlope = static_cast<Slope>(value); break;
+            default: break;     // the others are read on the control grid, after the timer
+        }
+    }
+}
 
 //==============================================================================
 LAUTEQAudioProcessor::LAUTEQAudioProcessor()
@@ -16,17 +108,38 @@ LAUTEQAudioProcessor::LAUTEQAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
                        )
 #endif
 {
+    // resolved once, so saving and loading state never looks parameters up by name
+    for( int i = 0; i < numStateParameters; ++i )
+    {
+        stateParameters[(size_t) i] = apvts.getParameter(stateParameterIDs[i]);
+        jassert( stateParameters[(size_t) i] != nullptr );
+    }
+    
+    for( auto& target : controllerTargets )
+        target.store(-1);
+    
+    for( auto& pending : controllerValuePending )
+        pending.store(false);
     
+    startTimerHz(30);
+    
+    for( auto& engine : engines )
+        engine.setCoefficientStore(&coefficientStore.getObject());
+    
+    for( auto& program : factoryPrograms )
+        programNames.add(program.name);
 }
 
 LAUTEQAudioProcessor::~LAUTEQAudioProcessor()
 {
+    stopTimer();
 }
 
 
@@ -70,39 +183,164 @@ double LAUTEQAudioProcessor::getTailLengthSeconds() const
 
 int LAUTEQAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return numFactoryPrograms;
 }
 
 int LAUTEQAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return currentProgram;
 }
 
 void LAUTEQAudioProcessor::setCurrentProgram (int index)
 {
+    if( ! juce::isPositiveAndBelow(index, numFactoryPrograms) )
+        return;
+    
+    currentProgram = index;
+    
+    // Some hosts do this on the audio thread. Setting the parameters notifies the host,
+    // and handing a design over may free the one before it, so there the index is only
+    // left for the timer, like a MIDI controller's value.
+    if( ! juce::MessageManager::existsAndIsCurrentThread() )
+    {
+        pendingProgram.store(index);
+        return;
+    }
+    
+    pendingProgram.store(-1);
+    recallSettings(factoryPrograms[index].settings, programDesigns[index]);
 }
 
 const juce::String LAUTEQAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return programNames[index];
 }
 
 void LAUTEQAudioProcessor::changeProgramName (int index, const juce::String& newName)
 {
+    if( juce::isPositiveAndBelow(index, numFactoryPrograms) )
+        programNames.set(index, newName);
 }
 
 //==============================================================================
-void LAUTEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+void LAUTEQAudioProcessor::selectCompareSlot(CompareSlot slot)
+{
+    if( slot == compareSlot )
+        return;
+    
+    // keep whatever was edited in the slot we leave, designed while we are off the audio thread
+    auto& leaving = compareSlots[(size_t) compareSlot];
+    leaving.settings = getChainSettings(apvts);
+    leaving.design = getSampleRate() > 0 ? new ChainDesign(leaving.settings, getSampleRate(), &coefficientStore.getObject()) : nullptr;
+    leaving.filled = true;
+    
+    compareSlot = slot;
+    auto& entering = compareSlots[(size_t) slot];
+    
+    // an empty slot starts as a copy, so there is nothing to switch to
+    if( ! entering.filled )
+    {
+        entering = leaving;
+        return;
+    }
+    
+    recallSettings(entering.settings, entering.design);
+}
+
+void LAUTEQAudioProcessor::copyToOtherCompareSlot()
+{
+    auto& other = compareSlots[(size_t) (compareSlot == SlotA ? SlotB : SlotA)];
+    other.settings = getChainSettings(apvts);
+    other.design = getSampleRate() > 0 ? new ChainDesign(other.settings, getSampleRate(), &coefficientStore.getObject()) : nullptr;
+    other.filled = true;
+}
+
+void LAUTEQAudioProcessor::setChainSettings(const ChainSettings& settings)
+{
+    const float values[numChainParameters]
+    {
+        settings.lowCutFreq,
+        settings.highCutFreq,
+        settings.peakFreq,
+        settings.peakGainInDecibels,
+        settings.peakQuality,
+        (float) settings.lowCutSlope,
+        (float) settings.highCutSlope
+    };
+    
+    for( int i = 0; i < numChainParameters; ++i )
+    {
+        auto* param = stateParameters[(size_t) i];
+        param->setValueNotifyingHost(param->convertTo0to1(values[i]));
+    }
+}
+
+// what the parameters hold after setChainSettings, they snap to their intervals
+ChainSettings LAUTEQAudioProcessor::getSnappedSettings(const ChainSettings& settings) const
 {
+    auto snap = [this](int index, float value)
+    {
+        auto* param = stateParameters[(size_t) index];
+        return param->convertFrom0to1(param->convertTo0to1(value));
+    };
+    
+    // the slopes are whole choices already
+    auto snapped = settings;
+    snapped.lowCutFreq = snap(0, settings.lowCutFreq);
+    snapped.highCutFreq = snap(1, settings.highCutFreq);
+    snapped.peakFreq = snap(2, settings.peakFreq);
+    snapped.peakGainInDecibels = snap(3, settings.peakGainInDecibels);
+    snapped.peakQuality = snap(4, settings.peakQuality);
+    return snapped;
+}
+
+void LAUTEQAudioProcessor::recallSettings(const ChainSettings& settings, ChainDesign::Ptr design)
+{
+    // While the parameters change one by one processBlock must not design the half-set
+    // state, the flag stays up until the finished design has been handed over.
+    designSwitchPending = true;
+    
+    setChainSettings(settings);
+    
+    auto sampleRate = getSampleRate();
+    if( sampleRate > 0 )
+    {
+        // the parameters snap to their intervals, design what they actually hold
+        auto actual = getChainSettings(apvts);
+        
+        if( design == nullptr || design->settings != actual || design->sampleRate != sampleRate )
+            design = new ChainDesign(actual, sampleRate, &coefficientStore.getObject());
+        
+        handOverDesign(design);
+    }
     
+    designSwitchPending = false;
+}
+
+void LAUTEQAudioProcessor::handOverDesign(ChainDesign::Ptr design)
+{
+    ChainDesign::Ptr released;      // let go of after the lock
     
-    // This structure is passed into a DSP algorithm's prepare() method, and contains
-    // information about various aspects of the context in which it can expect to be called.
-    juce::dsp::ProcessSpec spec;
-    spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = 1;
-    spec.sampleRate = sampleRate;
+    {
+        const juce::SpinLock::ScopedLockType sl(handOverLock);
+        
+        if( pendingDesign.exchange(design.get()) != nullptr )
+        {
+            released = std::move(queuedDesign);
+        }
+        else
+        {
+            released = std::move(takenDesign);
+            takenDesign = std::move(queuedDesign);
+        }
+        
+        queuedDesign = std::move(design);
+    }
+}
+
+//==============================================================================
+void LAUTEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
     
 //    //reset History array
 //    for (int i = 0; i < historyLength; i++ )
@@ -111,29 +349,76 @@ void LAUTEQAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock
 //    }
     
     
-    // prepare process spec
-    leftChain.prepare(spec);
-    rightChain.prepare(spec);
+    // the engines allocate nothing, they only need a clean state
+    for( auto& engine : engines )
+        engine.reset();
     
+    // mid/side is a stereo thing, any other main bus runs linked whatever the button says
+    canUseMidSide = getMainBusNumOutputChannels() == 2;
     
     updateFilters();
     
+    dynamicEQ.prepare(sampleRate);
+    dynamicSettings = getDynamicSettings(apvts);
+    dynamicEQ.setSettings(dynamicSettings);
+    
+    samplesUntilControlUpdate = 0;
+    
+    // anything still queued was designed for the old sample rate, and the slots and programs follow the new one
+    {
+        const juce::SpinLock::ScopedLockType sl(handOverLock);
+        pendingDesign.store(nullptr);
+        queuedDesign = nullptr;
+        takenDesign = nullptr;
+    }
+    
+    for( auto& slot : compareSlots )
+        if( slot.filled )
+            slot.design = new ChainDesign(slot.settings, sampleRate, &coefficientStore.getObject());
     
-    // PREPARE FIFO
-    leftChannelFifo.prepare(samplesPerBlock);
-    rightChannelFifo.prepare(samplesPerBlock);
+    programDesigns.clear();
+    for( auto& program : factoryPrograms )
+        programDesigns.add(new ChainDesign(getSnappedSettings(program.settings), sampleRate, &coefficientStore.getObject()));
     
+    auto numMainChannels = juce::jlimit(1, EQEngine::maxChannels, getMainBusNumOutputChannels());
     
-    osc.initialise([](float x) {return std::sin(x); });
+    // The fade buffer and the analyzer fifos share one block, which only grows. Laid out
+    // first, then placed: the analyzer's blocks have their own size, the host's may be
+    // anything and vary.
+    ArenaLayout layout;
+    std::array<size_t, EQEngine::maxChannels> fadeOffsets {};
+    for( int channel = 0; channel < numMainChannels; ++channel )
+        fadeOffsets[(size_t) channel] = layout.addFloats((size_t) samplesPerBlock);
     
+    auto numAnalyzerBlocks = getNumAnalyzerFifoBlocks(sampleRate);
+    leftChannelFifo.addToLayout(layout, analyzerBlockSize, numAnalyzerBlocks);
+    rightChannelFifo.addToLayout(layout, analyzerBlockSize, numAnalyzerBlocks);
     
-    // OSC Test FOR SPEC
-    spec.numChannels = getTotalNumOutputChannels();
-    osc.prepare(spec);
-    osc.setFrequency(200);
+    bufferArena.prepare(layout);
+    
+    std::array<float*, EQEngine::maxChannels> fadeChannels {};
+    for( int channel = 0; channel < numMainChannels; ++channel )
+        fadeChannels[(size_t) channel] = bufferArena.getFloats(fadeOffsets[(size_t) channel]);
+    
+    fadeBuffer.setDataToReferTo(fadeChannels.data(), numMainChannels, samplesPerBlock);
+    leftChannelFifo.prepare(bufferArena);
+    rightChannelFifo.prepare(bufferArena);
+    
+    fadeLength = juce::jmax(1, juce::roundToInt(sampleRate * crossfadeSeconds));
+    fadeSamplesRemaining = 0;
+    
+    
+    generator.prepare(sampleRate);
     
 }
 
+int LAUTEQAudioProcessor::getNumAnalyzerFifoBlocks(double sampleRate)
+{
+    // e.g. 8 blocks at 48 kHz, 170 ms
+    auto numBlocks = (int) std::ceil(analyzerFifoSeconds * sampleRate / analyzerBlockSize);
+    return juce::jlimit(2, maxAnalyzerFifoBlocks, numBlocks);
+}
+
 void LAUTEQAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
@@ -147,18 +432,27 @@ bool LAUTEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
+    // Mono, stereo, or anything wider up to EQEngine::maxChannels, which runs as stereo pairs.
     // Some plugin hosts, such as certain GarageBand versions, will only
     // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    auto numMainChannels = layouts.getMainOutputChannelSet().size();
+    if (numMainChannels < 1 || numMainChannels > EQEngine::maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // the sidechain is optional, mono or stereo
+    if (layouts.inputBuses.size() > 1)
+    {
+        auto sidechain = layouts.getChannelSet(true, 1);
+        if (! sidechain.isDisabled()
+         && sidechain != juce::AudioChannelSet::mono()
+         && sidechain != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -168,7 +462,7 @@ bool LAUTEQAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) c
 
 void LAUTEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    
+    LAUTEQ_TRACE_SCOPE("processBlock");
     
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
@@ -182,10 +476,33 @@ void LAUTEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     // this code if your algorithm always overwrites all the output channels.
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
+    
+    // the sidechain channels come after the main ones, only the main bus gets processed
+    auto numMainChannels = getMainBusNumOutputChannels();
+    
+    numSidechainChannels = 0;
+    if (auto* sidechainBus = getBus(true, 1); sidechainBus != nullptr && sidechainBus->isEnabled())
+    {
+        auto sidechain = getBusBuffer(buffer, true, 1);
+        numSidechainChannels = juce::jmin(sidechain.getNumChannels(), EQEngine::numLanes);
+        
+        for( int channel = 0; channel < numSidechainChannels; ++channel )
+            sidechainChannels[(size_t) channel] = sidechain.getReadPointer(channel);
+    }
+    
+    // Test signal in place of the input. While it is off this is one parameter read.
+    auto generatorType = static_cast<GeneratorType>((int) apvts.getRawParameterValue("Generator")->load());
+    if( generatorType != GeneratorOff || generator.getType() != GeneratorOff )
+    {
+        generator.setType(generatorType);
+        generator.setFrequency(apvts.getRawParameterValue("Generator Freq")->load());
+        generator.setLevel(apvts.getRawParameterValue("Generator Level")->load());
+        generator.process(buffer.getArrayOfWritePointers(), numMainChannels, buffer.getNumSamples());
+    }
 
     
     // Dist
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    for (int channel = 0; channel < numMainChannels; ++channel)
     {
         auto* channelData = buffer.getWritePointer(channel);
         
@@ -238,42 +555,80 @@ void LAUTEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
         }
     }
     
-    // Jump to update Filter function
-    updateFilters();
-    
+    // Parameters are looked at on a grid of controlInterval samples rather than per block,
+    // so a host sending a few samples at a time doesn't pay for the reads and compares
+    // every time. From controlInterval samples per block up this is every block.
+    if( samplesUntilControlUpdate <= 0 )
+    {
+        updateControls();
+        samplesUntilControlUpdate = controlInterval;
+    }
+    samplesUntilControlUpdate -= buffer.getNumSamples();
     
 
     // create dsp sample block initialized with buffer
-    juce::dsp::AudioBlock<float> block(buffer);
+    juce::dsp::AudioBlock<float> block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, (size_t) numMainChannels);
 
     
-//    // OSC
-//    buffer.clear();
-//    juce::dsp::ProcessContextReplacing<float> stereoContext(block);
-//    osc.process(stereoContext);
-    
-    
-    
-    /** Returns an AudioBlock that represents one of the channels in this block. */
-    auto leftBlock = block.getSingleChannelBlock(0);                                // get block channel 0 and store in leftBlock
-    auto rightBlock = block.getSingleChannelBlock(1);                               // get block channel 1 and store in rightBlock
-    
     
-    //This context is intended for use in situations where a single block is being used
-    //    for both the input and output, so it will return the same object for both its
-    //        getInputBlock() and getOutputBlock() methods.
+    // MIDI controllers are sample accurate: the filters run up to each mapped event, take
+    // the new value, and carry on from there. Without MIDI this is the plain block.
+    if( midiMessages.isEmpty() )
+    {
+        processFilters(block, 0);
+    }
+    else
+    {
+        auto numSamples = buffer.getNumSamples();
+        int start = 0;
+        
+        for( const auto metadata : midiMessages )
+        {
+            auto message = metadata.getMessage();
+            if( ! message.isController() )
+                continue;
             
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);               // replace leftcontext with leftBlock
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);             // replace rightcontext with rightBlock
-    
-    /** Process `context` through all inner processors in sequence. */
-    leftChain.process(leftContext);                                                 // process replacing
-    rightChain.process(rightContext);                                               // process replacing
+            auto parameterIndex = getControllerTarget(message.getControllerNumber());
+            if( parameterIndex < 0 )
+                continue;
+            
+            auto position = juce::jlimit(start, numSamples, metadata.samplePosition);
+            if( position > start )
+            {
+                auto subBlock = block.getSubBlock((size_t) start, (size_t) (position - start));
+                processFilters(subBlock, start);
+                start = position;
+            }
+            
+            applyControllerValue(parameterIndex, message.getControllerValue());
+        }
+        
+        if( start < numSamples )
+        {
+            auto rest = block.getSubBlock((size_t) start);
+            processFilters(rest, start);
+        }
+    }
     
     
     
-    leftChannelFifo.update(buffer);
-    rightChannelFifo.update(buffer);
+    // Analyzer tap, skipped entirely while no editor is listening, and while rendering
+    // offline: nobody watches a render go by, and the editor's FFTs would only take a core
+    // from it. The tap doesn't touch the output, so a render is the same either way.
+    auto tapWanted = analyzerSubscribers.get() > 0 && ! isNonRealtime();
+    if (tapWanted)
+    {
+        if (! analyzerTapActive)
+        {
+            leftChannelFifo.restartBlock();
+            rightChannelFifo.restartBlock();
+        }
+        
+        // in and out of the main bus have the same layout, see isBusesLayoutSupported
+        leftChannelFifo.update(buffer, numMainChannels);
+        rightChannelFifo.update(buffer, numMainChannels);
+    }
+    analyzerTapActive = tapWanted;
     
  //==============================================================================
     
@@ -297,6 +652,334 @@ void LAUTEQAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce:
     
 }
 
+void LAUTEQAudioProcessor::updateControls()
+{
+    // Filters. The settings are read before the handover state, a half-finished program
+    // change always shows up as either the pending flag or the pending design. A
+    // controller value the timer hasn't set yet counts as the parameter's, otherwise
+    // another parameter's change would design the band back to where it was. The flags
+    // are read first, see timerCallback.
+    std::array<bool, numChainParameters> controllerPending {};
+    for( int i = 0; i < numChainParameters; ++i )
+        controllerPending[(size_t) i] = controllerValuePending[(size_t) i].load();
+    
+    auto chainSettings = getChainSettings(apvts);
+    
+    for( int i = 0; i < numChainParameters; ++i )
+        if( controllerPending[(size_t) i] )
+            setChainValue(chainSettings, i, stateParameters[(size_t) i]->convertFrom0to1(controllerValues[(size_t) i].load()));
+    auto switchPending = designSwitchPending.get();
+    
+    // a switch during a crossfade waits until the fade is done
+    auto* design = fadeSamplesRemaining == 0 ? pendingDesign.exchange(nullptr) : nullptr;
+    
+    // Only a change of the parameters, pending controller values included, counts.
+    if( design != nullptr )
+    {
+        startDesignCrossfade(*design);
+    }
+    else if( ! switchPending && pendingDesign.load() == nullptr && chainSettings != lastParameterSettings )
+    {
+        if( chainSettings != appliedSettings )
+            updateFilters(chainSettings);
+        
+        lastParameterSettings = chainSettings;
+    }
+    
+    // Mid/side. The lanes mean something else after a mode switch, so that crossfades
+    // like a program change, and waits for a running fade the same way.
+    auto midSide = canUseMidSide && apvts.getRawParameterValue("Mid Side")->load() > 0.5f;
+    auto sideSettings = getSideChainSettings(apvts);
+    
+    if( midSide != appliedMidSide )
+    {
+        if( fadeSamplesRemaining == 0 )
+            startModeCrossfade(midSide, sideSettings);
+    }
+    else if( midSide && sideSettings != appliedSideSettings )
+    {
+        updateSideFilters(sideSettings);
+    }
+    
+    // Dynamic peak band. Switching it off puts the static gain straight back.
+    auto dynamics = getDynamicSettings(apvts);
+    if( dynamicSettings.enabled && ! dynamics.enabled )
+    {
+        dynamicEQ.reset();
+        setDynamicPeakGain(appliedSettings.peakGainInDecibels);
+    }
+    
+    dynamicSettings = dynamics;
+    dynamicEQ.setSettings(dynamics);
+    dynamicEQ.setDetectorBand(appliedSettings.peakFreq, appliedSettings.peakQuality);
+}
+
+void LAUTEQAudioProcessor::processFilters(juce::dsp::AudioBlock<float>& block, int startSample)
+{
+    if( ! dynamicSettings.enabled )
+    {
+        processEngines(block);
+        return;
+    }
+    
+    // Dynamic peak band: one gain per control interval, on the detector's grid, which runs
+    // on across blocks. Each piece gets the gain of the last complete interval, and the
+    // detector hears its dry input (or the sidechain) before the engines run over it.
+    auto numSamples = (int) block.getNumSamples();
+    auto useSidechain = dynamicSettings.useSidechain && numSidechainChannels > 0;
+    
+    for( int start = 0; start < numSamples; )
+    {
+        auto num = juce::jmin(dynamicEQ.getNumSamplesUntilUpdate(), numSamples - start);
+        auto subBlock = block.getSubBlock((size_t) start, (size_t) num);
+        
+        setDynamicPeakGain(juce::jlimit(-24.f, 24.f, appliedSettings.peakGainInDecibels - dynamicEQ.getGainReduction()));
+        
+        const float* detectorChannels[EQEngine::numLanes] {};
+        auto numDetectorChannels = useSidechain ? numSidechainChannels
+                                                : (int) juce::jmin(subBlock.getNumChannels(), (size_t) EQEngine::numLanes);
+        
+        for( int channel = 0; channel < numDetectorChannels; ++channel )
+            detectorChannels[channel] = useSidechain ? sidechainChannels[(size_t) channel] + startSample + start
+                                                     : subBlock.getChannelPointer((size_t) channel);
+        
+        dynamicEQ.process(detectorChannels, numDetectorChannels, num);
+        
+        processEngines(subBlock);
+        start += num;
+    }
+}
+
+void LAUTEQAudioProcessor::setDynamicPeakGain(float gainInDecibels)
+{
+    // A redesign of the peak band brings back the static gain, so compare with the design.
+    // In mid/side the dynamics belong to the mid peak band.
+    auto& engine = engines[(size_t) activeEngine];
+    auto& design = engine.getDesign(0);
+    
+    if( design.isBandActive(ChainPositions::Peak)
+        && std::abs(design.getBand(ChainPositions::Peak).gainInDecibels - gainInDecibels) > 0.01f )
+        engine.setPeakGain(ChainPositions::Peak, gainInDecibels, getMainLane());
+}
+
+bool LAUTEQAudioProcessor::shouldUseWorkers(int numChannels, int numSamples) const
+{
+    // live, a wakeup on another thread is a risk to the deadline, and short blocks
+    // (the dynamic band's control intervals among them) cost more to hand out than to run
+    return isNonRealtime()
+        && workerPool->getNumWorkers() > 0
+        && EQEngine::getNumPairs(numChannels) > 1
+        && numSamples >= minSamplesForWorkers;
+}
+
+void LAUTEQAudioProcessor::processEngines(juce::dsp::AudioBlock<float>& block)
+{
+    auto numChannels = (int) juce::jmin(block.getNumChannels(), (size_t) EQEngine::maxChannels);
+    
+    auto processEngine = [this, numChannels](EQEngine& engine, juce::dsp::AudioBlock<float>& blockToUse)
+    {
+        float* channels[EQEngine::maxChannels] {};
+        for( int channel = 0; channel < numChannels; ++channel )
+            channels[channel] = blockToUse.getChannelPointer((size_t) channel);
+        
+        auto numSamples = (int) blockToUse.getNumSamples();
+        
+        // the pairs share nothing but the coefficients, one task each. With the pool
+        // busy rendering another track, this one does its pairs itself
+        auto processPair = [&](int pair) { engine.processPair(pair, channels, numChannels, numSamples); };
+        
+        if( ! shouldUseWorkers(numChannels, numSamples) || ! workerPool->tryRun(EQEngine::getNumPairs(numChannels), processPair) )
+            engine.process(channels, numChannels, numSamples);
+    };
+    
+    auto& engine = engines[(size_t) activeEngine];
+    
+    if( fadeSamplesRemaining == 0 )
+    {
+        processEngine(engine, block);
+        return;
+    }
+    
+    // Crossfade after a design switch: the previous engine keeps running on a copy of the
+    // input until the new one has faded in. Done in pieces of the prepared fade buffer.
+    auto& fadingEngine = engines[(size_t) (1 - activeEngine)];
+    
+    auto numSamples = block.getNumSamples();
+    size_t start = 0;
+    
+    while( start < numSamples && fadeSamplesRemaining > 0 )
+    {
+        auto num = juce::jmin(numSamples - start, (size_t) fadeBuffer.getNumSamples());
+        auto subBlock = block.getSubBlock(start, num);
+        auto fadeBlock = juce::dsp::AudioBlock<float>(fadeBuffer).getSubBlock(0, num);
+        
+        fadeBlock.copyFrom(subBlock);
+        processEngine(engine, subBlock);
+        processEngine(fadingEngine, fadeBlock);
+        
+        for( size_t channel = 0; channel < (size_t) numChannels; ++channel )
+        {
+            auto* out = subBlock.getChannelPointer(channel);
+            auto* fading = fadeBlock.getChannelPointer(channel);
+            
+            for( size_t i = 0; i < num; ++i )
+            {
+                auto remaining = juce::jmax(0, fadeSamplesRemaining - (int) i);
+                auto fadeOut = (float) remaining / (float) fadeLength;
+                out[i] += fadeOut * (fading[i] - out[i]);
+            }
+        }
+        
+        fadeSamplesRemaining = juce::jmax(0, fadeSamplesRemaining - (int) num);
+        start += num;
+    }
+    
+    if( start < numSamples )
+    {
+        auto rest = block.getSubBlock(start);
+        processEngine(engine, rest);
+    }
+}
+
+EQEngine& LAUTEQAudioProcessor::beginCrossfade()
+{
+    // the engine that was playing fades out, the other one starts clean
+    activeEngine = 1 - activeEngine;
+    
+    auto& engine = engines[(size_t) activeEngine];
+    engine.reset();
+    
+    fadeSamplesRemaining = fadeLength;
+    return engine;
+}
+
+void LAUTEQAudioProcessor::startDesignCrossfade(const ChainDesign& design)
+{
+    auto& engine = beginCrossfade();
+    engine.setMidSide(appliedMidSide);
+    engine.setDesign(design.coefficients, getMainLane());
+    
+    // a program only carries the parameter chain, the side lane stays as it is
+    if( appliedMidSide )
+        engine.setDesign(engines[(size_t) (1 - activeEngine)].getDesign(1), 1);
+    
+    appliedSettings = design.settings;
+}
+
+void LAUTEQAudioProcessor::startModeCrossfade(bool midSide, const ChainSettings& sideSettings)
+{
+    auto& fadingEngine = engines[(size_t) activeEngine];
+    auto& engine = beginCrossfade();
+    
+    appliedMidSide = midSide;
+    engine.setMidSide(midSide);
+    engine.setDesign(fadingEngine.getDesign(0));
+    
+    if( midSide )
+    {
+        updateChangedBands(sideSettings, appliedSettings, 1);
+        appliedSideSettings = sideSettings;
+    }
+}
+
+//==============================================================================
+void LAUTEQAudioProcessor::learnMidiController(int parameterIndex)
+{
+    controllerToLearn.store(juce::isPositiveAndBelow(parameterIndex, numStateParameters) ? parameterIndex : -1);
+}
+
+void LAUTEQAudioProcessor::clearMidiControllers()
+{
+    controllerToLearn.store(-1);
+    
+    for( auto& target : controllerTargets )
+        target.store(-1);
+}
+
+juce::String LAUTEQAudioProcessor::getStateParameterName(int parameterIndex) const
+{
+    return stateParameters[(size_t) parameterIndex]->getName(64);
+}
+
+int LAUTEQAudioProcessor::getControllerTarget(int controllerNumber)
+{
+    // a pending learn takes the first controller that comes along, one controller per parameter
+    if( controllerToLearn.load() >= 0 )
+    {
+        auto parameterIndex = controllerToLearn.exchange(-1);
+        
+        if( parameterIndex >= 0 )
+        {
+            for( auto& target : controllerTargets )
+                if( target.load() == parameterIndex )
+                    target.store(-1);
+            
+            controllerTargets[(size_t) controllerNumber].store((int8_t) parameterIndex);
+        }
+    }
+    
+    return controllerTargets[(size_t) controllerNumber].load();
+}
+
+void LAUTEQAudioProcessor::applyControllerValue(int parameterIndex, int controllerValue)
+{
+    auto* param = stateParameters[(size_t) parameterIndex];
+    auto normalisedValue = (float) controllerValue / 127.f;
+    
+    // the parameter snaps exactly like this once the timer has set it
+    auto settings = appliedSettings;
+    setChainValue(settings, parameterIndex, param->convertFrom0to1(normalisedValue));
+    
+    // no host call from here, see timerCallback
+    controllerValues[(size_t) parameterIndex].store(normalisedValue);
+    controllerValuePending[(size_t) parameterIndex].store(true);
+    
+    // a program switch in flight owns the filters until it has been handed over
+    if( ! designSwitchPending.get() && pendingDesign.load() == nullptr )
+        updateFilters(settings);
+}
+
+void LAUTEQAudioProcessor::timerCallback()
+{
+    auto program = pendingProgram.exchange(-1);
+    if( juce::isPositiveAndBelow(program, numFactoryPrograms) )
+        recallSettings(factoryPrograms[program].settings, programDesigns[program]);
+    
+    // The flag is cleared only once the parameter holds the value, updateControls reads the
+    // flag before the parameter. A value the audio thread stored meanwhile keeps it up.
+    for( int i = 0; i < numStateParameters; ++i )
+    {
+        auto& pending = controllerValuePending[(size_t) i];
+        if( ! pending.load() )
+            continue;
+        
+        auto value = controllerValues[(size_t) i].load();
+        stateParameters[(size_t) i]->setValueNotifyingHost(value);
+        
+        pending.store(false);
+        if( controllerValues[(size_t) i].load() != value )
+            pending.store(true);
+    }
+}
+
+void LAUTEQAudioProcessor::addAnalyzerSubscriber()
+{
+    // the tap is off while nobody listens, so whatever is still queued is stale
+    if (analyzerSubscribers.get() == 0)
+    {
+        leftChannelFifo.discardCompleteBuffers();
+        rightChannelFifo.discardCompleteBuffers();
+    }
+    
+    ++analyzerSubscribers;
+}
+
+void LAUTEQAudioProcessor::removeAnalyzerSubscriber()
+{
+    jassert (analyzerSubscribers.get() > 0);
+    --analyzerSubscribers;
+}
+
 //==============================================================================
 bool LAUTEQAudioProcessor::hasEditor() const
 {
@@ -316,20 +999,72 @@ void LAUTEQAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
-    juce::MemoryOutputStream mos(destData, true);
-    apvts.state.writeToStream(mos);
+    juce::MemoryOutputStream mos(destData, false);
+    mos.preallocate(stateHeaderSize + numStateParameters * (int) sizeof(float) + numMidiControllers);
+    
+    mos.writeInt(stateMagic);
+    mos.writeShort((short) stateVersion);
+    mos.writeShort((short) numStateParameters);
+    
+    for( auto* param : stateParameters )
+        mos.writeFloat(param->convertFrom0to1(param->getValue()));
+    
+    for( auto& target : controllerTargets )
+        mos.writeByte((char) target.load());
 }
 
 void LAUTEQAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
     // You should use this method to restore your parameters from this memory block,
     // whose contents will have been created by the getStateInformation() call.
+    //
+    // Neither path touches the filters, processBlock designs the new coefficients at
+    // the start of the next block, on the audio thread, like for any other change.
+    //
+    // The generator's settings come back, the generator itself always comes back off:
+    // a session saved in the middle of a measurement doesn't reopen playing a test signal.
+    auto* generatorType = apvts.getParameter("Generator");
+    
+    if( sizeInBytes >= stateHeaderSize )
+    {
+        juce::MemoryInputStream mis(data, (size_t) sizeInBytes, false);
+        
+        if( mis.readInt() == stateMagic )
+        {
+            auto version = (int) (unsigned short) mis.readShort();
+            auto numValues = (int) (unsigned short) mis.readShort();
+            
+            // numValues covers values this version doesn't know yet, they're skipped over
+            auto controllersStart = stateHeaderSize + numValues * (int) sizeof(float);
+            numValues = juce::jmin(numValues, numStateParameters, (sizeInBytes - stateHeaderSize) / (int) sizeof(float));
+            
+            for( int i = 0; i < numStateParameters; ++i )
+            {
+                auto* param = stateParameters[(size_t) i];
+                auto value = i < numValues ? param->convertTo0to1(mis.readFloat()) : param->getDefaultValue();
+                param->setValueNotifyingHost(param == generatorType ? param->getDefaultValue() : value);
+            }
+            
+            // sessions from before MIDI learn have no controller map
+            auto hasControllers = version >= 2 && sizeInBytes >= controllersStart + numMidiControllers;
+            mis.setPosition(controllersStart);
+            
+            for( auto& target : controllerTargets )
+            {
+                auto index = hasControllers ? (int) (int8_t) mis.readByte() : -1;
+                target.store((int8_t) (juce::isPositiveAndBelow(index, numStateParameters) ? index : -1));
+            }
+            
+            return;
+        }
+    }
     
-    auto tree = juce::ValueTree::readFromData(data, sizeInBytes);
+    // older sessions, saved as a ValueTree
+    auto tree = juce::ValueTree::readFromData(data, (size_t) sizeInBytes);
     if( tree.isValid() )
     {
         apvts.replaceState(tree);
-        updateFilters();
+        generatorType->setValueNotifyingHost(generatorType->getDefaultValue());
     }
 }
 
@@ -349,63 +1084,91 @@ ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts)
     return settings;
 }
 
-// PEAK processor change
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts)
+{
+    ChainSettings settings;
+    
+    settings.lowCutFreq = apvts.getRawParameterValue("Side LowCut Freq")->load();
+    settings.highCutFreq = apvts.getRawParameterValue("Side HighCut Freq")->load();
+    settings.peakFreq = apvts.getRawParameterValue("Side Peak Freq")->load();
+    settings.peakGainInDecibels = apvts.getRawParameterValue("Side Peak Gain")->load();
+    settings.peakQuality = apvts.getRawParameterValue("Side Peak Quality")->load();
+    settings.lowCutSlope = static_cast<Slope>(apvts.getRawParameterValue("Side LowCut Slope")->load());
+    settings.highCutSlope = static_cast<Slope>(apvts.getRawParameterValue("Side HighCut Slope")->load());
+    
+    return settings;
+}
 
-Coefficients makePeakFilter(const ChainSettings& chainSettings, double sampleRate)
+DynamicSettings getDynamicSettings(juce::AudioProcessorValueTreeState& apvts)
 {
-    return juce::dsp::IIR::Coefficients<float>::makePeakFilter(sampleRate,
-                                                               chainSettings.peakFreq,                 // get settings from apvts string fader
-                                                               chainSettings.peakQuality,              // get settings from apvts string peak q
-                                                               juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels)); // range
+    DynamicSettings settings;
+    
+    settings.enabled = apvts.getRawParameterValue("Peak Dynamic")->load() > 0.5f;
+    settings.useSidechain = apvts.getRawParameterValue("Peak Sidechain")->load() > 0.5f;
+    settings.thresholdInDecibels = apvts.getRawParameterValue("Peak Threshold")->load();
+    settings.ratio = apvts.getRawParameterValue("Peak Ratio")->load();
+    settings.attackMs = apvts.getRawParameterValue("Peak Attack")->load();
+    settings.releaseMs = apvts.getRawParameterValue("Peak Release")->load();
     
+    return settings;
 }
 
-void LAUTEQAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings)
+//==============================================================================
+BandSettings makeLowCutBand(const ChainSettings& chainSettings)
 {
-    // define peak filter
-//    auto peakCoefficients = juce::dsp::IIR::Coefficients<float>::makePeakFilter(getSampleRate(),                        // sample rate
-//                                                                                chainSettings.peakFreq,                 // get settings from apvts string fader
-//                                                                                chainSettings.peakQuality,              // get settings from apvts string peak q
-//                                                                                juce::Decibels::decibelsToGain(chainSettings.peakGainInDecibels)); // range
-//
-    auto peakCoefficients = makePeakFilter(chainSettings, getSampleRate());
-    updateCoefficients(leftChain.template get<ChainPositions::Peak>().coefficients, peakCoefficients);
-    updateCoefficients(rightChain.template get<ChainPositions::Peak>().coefficients, peakCoefficients);
+    BandSettings band;
+    band.type = LowCutBand;
+    band.frequency = chainSettings.lowCutFreq;
+    band.order = 2 * (chainSettings.lowCutSlope + 1);
+    return band;
 }
 
-void updateCoefficients(Coefficients& old, const Coefficients& replacements)
-    {
-        *old = *replacements;
-    }
+BandSettings makePeakBand(const ChainSettings& chainSettings)
+{
+    BandSettings band;
+    band.type = PeakBand;
+    band.frequency = chainSettings.peakFreq;                        // get settings from apvts string fader
+    band.quality = chainSettings.peakQuality;                       // get settings from apvts string peak q
+    band.gainInDecibels = chainSettings.peakGainInDecibels;         // range
+    return band;
+}
 
-//LOWCUT processor change
+BandSettings makeHighCutBand(const ChainSettings& chainSettings)
+{
+    BandSettings band;
+    band.type = HighCutBand;
+    band.frequency = chainSettings.highCutFreq;
+    band.order = 2 * (chainSettings.highCutSlope + 1);
+    return band;
+}
 
-void LAUTEQAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings)
+void setChainBands(EQDesign& design, const ChainSettings& chainSettings, double sampleRate, CoefficientStore* store)
 {
-    
-    auto cutCoefficients = makeLowCutFilter(chainSettings, getSampleRate());
-    auto& leftLowCut = leftChain.get<ChainPositions::LowCut>();
-    auto& rightLowCut = rightChain.get<ChainPositions::LowCut>();
-    
-    updateCutFilter(leftLowCut, cutCoefficients, chainSettings. lowCutSlope);
-    updateCutFilter(rightLowCut, cutCoefficients, chainSettings.lowCutSlope);
+    design.setBand(ChainPositions::LowCut, makeLowCutBand(chainSettings), sampleRate, store);
+    design.setBand(ChainPositions::Peak, makePeakBand(chainSettings), sampleRate, store);
+    design.setBand(ChainPositions::HighCut, makeHighCutBand(chainSettings), sampleRate, store);
+}
 
-    
+// PEAK processor change
+
+void LAUTEQAudioProcessor::updatePeakFilter(const ChainSettings &chainSettings, int lane)
+{
+    engines[(size_t) activeEngine].setBand(ChainPositions::Peak, makePeakBand(chainSettings), getSampleRate(), lane);
+}
+
+//LOWCUT processor change
+
+void LAUTEQAudioProcessor::updateLowCutFilters(const ChainSettings &chainSettings, int lane)
+{
+    engines[(size_t) activeEngine].setBand(ChainPositions::LowCut, makeLowCutBand(chainSettings), getSampleRate(), lane);
 }
 
 
 // HIGHCUT processor change
 
-    void LAUTEQAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings)
+void LAUTEQAudioProcessor::updateHighCutFilters(const ChainSettings &chainSettings, int lane)
 {
-    
-    auto highCutCoefficients = makeHighCutFilter(chainSettings, getSampleRate());
-    auto& leftHighCut = leftChain.get<ChainPositions::HighCut>();
-    auto& rightHighCut = rightChain.get<ChainPositions::HighCut>();
-    
-    updateCutFilter(leftHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    updateCutFilter(rightHighCut, highCutCoefficients, chainSettings.highCutSlope);
-    
+    engines[(size_t) activeEngine].setBand(ChainPositions::HighCut, makeHighCutBand(chainSettings), getSampleRate(), lane);
 }
 
 
@@ -415,9 +1178,55 @@ void LAUTEQAudioProcessor::updateFilters()
 {
     auto chainSettings = getChainSettings(apvts);
     
-    updateLowCutFilters(chainSettings);
-    updatePeakFilter(chainSettings);
-    updateHighCutFilters(chainSettings);
+    appliedMidSide = canUseMidSide && apvts.getRawParameterValue("Mid Side")->load() > 0.5f;
+    engines[(size_t) activeEngine].setMidSide(appliedMidSide);
+    
+    updateLowCutFilters(chainSettings, EQEngine::allLanes);
+    updatePeakFilter(chainSettings, EQEngine::allLanes);
+    updateHighCutFilters(chainSettings, EQEngine::allLanes);
+    
+    appliedSettings = chainSettings;
+    
+    if( appliedMidSide )
+    {
+        appliedSideSettings = getSideChainSettings(apvts);
+        updateChangedBands(appliedSideSettings, appliedSettings, 1);
+    }
+}
+
+void LAUTEQAudioProcessor::updateFilters(const ChainSettings& chainSettings)
+{
+    updateChangedBands(chainSettings, appliedSettings, getMainLane());
+    appliedSettings = chainSettings;
+}
+
+void LAUTEQAudioProcessor::updateSideFilters(const ChainSettings& sideSettings)
+{
+    updateChangedBands(sideSettings, appliedSideSettings, 1);
+    appliedSideSettings = sideSettings;
+}
+
+void LAUTEQAudioProcessor::updateChangedBands(const ChainSettings& chainSettings, const ChainSettings& previous, int lane)
+{
+    // only the sections whose inputs changed get redesigned
+    if( chainSettings.lowCutFreq != previous.lowCutFreq || chainSettings.lowCutSlope != previous.lowCutSlope )
+        updateLowCutFilters(chainSettings, lane);
+    
+    if( chainSettings.peakFreq != previous.peakFreq
+        || chainSettings.peakGainInDecibels != previous.peakGainInDecibels
+        || chainSettings.peakQuality != previous.peakQuality )
+        updatePeakFilter(chainSettings, lane);
+    
+    if( chainSettings.highCutFreq != previous.highCutFreq || chainSettings.highCutSlope != previous.highCutSlope )
+        updateHighCutFilters(chainSettings, lane);
+}
+
+//==============================================================================
+ChainDesign::ChainDesign(const ChainSettings& settingsToUse, double sampleRateToUse, CoefficientStore* store)
+    : settings(settingsToUse),
+      sampleRate(sampleRateToUse)
+{
+    setChainBands(coefficients, settings, sampleRate, store);
 }
 
 
@@ -468,6 +1277,80 @@ void LAUTEQAudioProcessor::updateFilters()
     layout.add(std::make_unique<juce::AudioParameterChoice>("HighCut Slope", "HighCut Slope", stringArray, 0 ));
     
     
+    // Dynamic peak band
+    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Dynamic", "Peak Dynamic", false));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Threshold",
+                                                           "Peak Threshold",
+                                                           juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f),
+                                                           -24.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Ratio",
+                                                           "Peak Ratio",
+                                                           juce::NormalisableRange<float>(1.f, 20.f, 0.1f, 0.5f),
+                                                           2.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Attack",
+                                                           "Peak Attack",
+                                                           juce::NormalisableRange<float>(0.1f, 200.f, 0.1f, 0.4f),
+                                                           10.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Peak Release",
+                                                           "Peak Release",
+                                                           juce::NormalisableRange<float>(5.f, 2000.f, 1.f, 0.4f),
+                                                           150.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterBool>("Peak Sidechain", "Peak Sidechain", false));
+    
+    
+    // Mid/side, the parameters above drive mid and these side
+    layout.add(std::make_unique<juce::AudioParameterBool>("Mid Side", "Mid Side", false));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Side LowCut Freq",
+                                                           "Side LowCut Freq",
+                                                           juce::NormalisableRange<float>(20.f,20000.f, 1.f, 0.25f),
+                                                           20.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Side HighCut Freq",
+                                                           "Side HighCut Freq",
+                                                           juce::NormalisableRange<float>(20.f,20000.f, 1.f, 0.25f),
+                                                           20000.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Side Peak Freq",
+                                                           "Side Peak Freq",
+                                                           juce::NormalisableRange<float>(20.f,20000.f, 1.f, 0.25f),
+                                                           750.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Side Peak Gain",
+                                                           "Side Peak Gain",
+                                                           juce::NormalisableRange<float>(-24.f, 24.f, 0.5f, 1.f),
+                                                           0.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Side Peak Quality",
+                                                           "Side Peak Quality",
+                                                           juce::NormalisableRange<float>(0.1f, 10.f, 0.05f, 1.f),
+                                                           1.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Side LowCut Slope", "Side LowCut Slope", stringArray, 0 ));
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Side HighCut Slope", "Side HighCut Slope", stringArray, 0 ));
+    
+    
+    // Test signal, see SignalGenerator
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Generator", "Generator",
+                                                            juce::StringArray { "Off", "Sine", "Sweep", "White Noise", "Pink Noise", "Impulse" },
+                                                            GeneratorOff));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Generator Freq",
+                                                           "Generator Freq",
+                                                           juce::NormalisableRange<float>(20.f,20000.f, 1.f, 0.25f),
+                                                           1000.f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Generator Level",
+                                                           "Generator Level",
+                                                           juce::NormalisableRange<float>(-60.f, 0.f, 0.5f, 1.f),
+                                                           -18.f));
+    
+    
     
     //juce::StringArray distArray;
     
@@ -9,6 +9,12 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "EQEngine.h"
+#include "DynamicEQ.h"
+#include "CoefficientStore.h"
+#include "SignalGenerator.h"
+#include "ChannelWorkerPool.h"
+#include "BufferArena.h"
 
 /// Fifo to GUI
 // FFT DATA GENERATOR
@@ -18,24 +24,43 @@
 /// FFT NEEDS FCSC To Prepare FFT Data Blocks in Array
 
 #include <array>
-template<typename T>
+
+// Capacity is the number of items it holds. juce::AbstractFifo keeps a slot free to tell
+// full from empty, so there is one slot more. Every slot is allocated at its full size in
+// prepare, so keep it to what the reader can fall behind by, see getMemoryUsage.
+template<typename T, int Capacity = 30>
 struct Fifo
 {
-    void prepare(int numChannels, int numSamples)
+    // The slots' samples live in a BufferArena: addToLayout reserves them, prepare(arena)
+    // points the slots at them once the arena has been prepared with that layout. numItems
+    // can be less than Capacity, only the slots for that many are laid out then.
+    void addToLayout(ArenaLayout& layout, int numChannels, int numSamples, int numItems = Capacity)
     {
-        
         static_assert( std::is_same_v<T,
                       juce::AudioBuffer<float>>,
-                      "prepare(numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
+                      "addToLayout(layout, numChannels, numSamples) should only be used when the Fifo is holding juce::AudioBuffer<float>");
+        
+        jassert( numChannels <= maxSlotChannels );
+        slotChannels = juce::jmin(numChannels, maxSlotChannels);
+        slotSamples = numSamples;
+        
+        jassert( numItems > 0 && numItems <= Capacity );
+        numSlots = juce::jlimit(1, Capacity, numItems) + 1;
+        fifo.setTotalSize(numSlots);
         
-        for( auto& buffer : buffers)
+        for( int i = 0; i < numSlots; ++i )
+            slotOffsets[(size_t) i] = layout.addFloats((size_t) slotChannels * (size_t) slotSamples);
+    }
+    
+    void prepare(BufferArena& arena)
+    {
+        for( int i = 0; i < numSlots; ++i )
         {
-            buffer.setSize(numChannels,
-                           numSamples,
-                           false,   //clear everything?
-                           true,    //including the extra space?
-                           true);   //avoid reallocating if you can?
-            buffer.clear();
+            std::array<float*, maxSlotChannels> channels {};
+            for( int channel = 0; channel < slotChannels; ++channel )
+                channels[(size_t) channel] = arena.getFloats(slotOffsets[(size_t) i]) + channel * slotSamples;
+            
+            buffers[(size_t) i].setDataToReferTo(channels.data(), slotChannels, slotSamples);
         }
     }
     
@@ -43,8 +68,8 @@ struct Fifo
     
     void prepare(size_t numElements)
     {
-        static_assert( std::is_same_v<T, std::vector<float>>,
-                      "prepare(numElements) should only be used when the Fifo is holding std::vector<float>");
+        static_assert( std::is_same_v<T, std::vector<typename T::value_type>>,
+                      "prepare(numElements) should only be used when the Fifo is holding a std::vector");
         
         for( auto& buffer : buffers )
         {
@@ -81,16 +106,85 @@ struct Fifo
         return false;
     }
     
+    // Same as push and pull, but t trades places with the slot instead of being copied.
+    // A juce::Path copy always allocates, a swap never does: the storage just circulates
+    // between the writer, the slots and the reader.
+    bool pushBySwapping(T& t)
+    {
+        auto write = fifo.write(1);
+        if( write.blockSize1 > 0 )
+        {
+            std::swap(buffers[write.startIndex1], t);
+            return true;
+        }
+        
+        return false;
+    }
+    
+    bool pullBySwapping(T& t)
+    {
+        auto read = fifo.read(1);
+        if( read.blockSize1 > 0 )
+        {
+            std::swap(t, buffers[read.startIndex1]);
+            return true;
+        }
+        
+        return false;
+    }
+    
     int getNumAvailableForReading() const
     {
         return fifo.getNumReady();
     }
     
+    // Throw away everything waiting to be read, reader side only
+    void discardAvailable()
+    {
+        fifo.read(fifo.getNumReady());
+    }
+    
+    int getNumItems() const { return numSlots - 1; }
+    
+    // bytes held by the slots in use, for the analyzer memory report
+    size_t getMemoryUsage() const
+    {
+        auto bytes = sizeof(buffers);
+        
+        for( int i = 0; i < numSlots; ++i )
+        {
+            auto& buffer = buffers[(size_t) i];
+            
+            if constexpr (std::is_same_v<T, juce::AudioBuffer<float>>)
+                bytes += (size_t) buffer.getNumChannels() * (size_t) buffer.getNumSamples() * sizeof(float);
+            else if constexpr (std::is_same_v<T, juce::Path>)
+                bytes += getPathCoordinates(buffer) * sizeof(float);
+            else
+                bytes += buffer.capacity() * sizeof(typename T::value_type);
+        }
+        
+        return bytes;
+    }
     
 private:
-    static constexpr int Capacity = 30;
-    std::array<T, Capacity> buffers;
-    juce::AbstractFifo fifo {Capacity};
+    // a path keeps three floats per element, juce::Path doesn't say how many it has reserved
+    static size_t getPathCoordinates(const juce::Path& path)
+    {
+        size_t numElements = 0;
+        for( juce::Path::Iterator i(path); i.next(); )
+            ++numElements;
+        
+        return numElements * 3;
+    }
+    
+    std::array<T, Capacity + 1> buffers;
+    juce::AbstractFifo fifo {Capacity + 1};
+    int numSlots = Capacity + 1;
+    
+    // audio buffers only, where their samples are in the arena
+    static constexpr int maxSlotChannels = 2;
+    std::array<size_t, Capacity + 1> slotOffsets {};
+    int slotChannels = 0, slotSamples = 0;
 };
 
 
@@ -109,7 +203,8 @@ enum Channel
 //FB (Fixed Blocked)
 //This format designation means that several logical records are combined into one physical block. This format can provide efficient space utilization and operation. This format is commonly used for fixed-length records.
 
-template<typename BlockType>
+// Capacity is the most blocks it can be sized for, addToLayout picks how many it holds
+template<typename BlockType, int Capacity = 30>
 struct SingleChannelSampleFifo
 {
     
@@ -120,12 +215,13 @@ struct SingleChannelSampleFifo
     }
     
     
-    // Process Block update with buffer for each channel
-    void update(const BlockType& buffer)
+    // Process Block update with the main bus, the first numMainChannels of buffer. The
+    // channels after it are the sidechain's. A mono bus feeds every fifo from channel 0.
+    void update(const BlockType& buffer, int numMainChannels)
     {
         jassert(prepared.get());
-        jassert(buffer.getNumChannels() > channelToUse );
-        auto* channelPtr = buffer.getReadPointer(channelToUse);
+        jassert(numMainChannels > 0 && buffer.getNumChannels() >= numMainChannels);
+        auto* channelPtr = buffer.getReadPointer(juce::jmin((int) channelToUse, numMainChannels - 1));
         
         for( int i = 0; i < buffer.getNumSamples(); ++i )
         {
@@ -134,18 +230,23 @@ struct SingleChannelSampleFifo
     }
     
     
-    // Prepare Buffer Prepare to play (samplesperBlock)
-    void prepare(int bufferSize)
+    // Prepare Buffer Prepare to play, in two steps: numBlocks blocks of bufferSize samples
+    // go into the layout, prepare(arena) takes them once the arena has been prepared with it
+    void addToLayout(ArenaLayout& layout, int bufferSize, int numBlocks)
     {
         prepared.set(false);
         size.set(bufferSize);
         
-        bufferToFill.setSize(1,             //channel
-                             bufferSize,    //num samples
-                             false,         //keepExistingContent
-                             true,          //clear extra space
-                             true);         //avoid reallocating
-        audioBufferFifo.prepare(1, bufferSize);
+        fillOffset = layout.addFloats((size_t) bufferSize);
+        audioBufferFifo.addToLayout(layout, 1, bufferSize, numBlocks);
+    }
+    
+    void prepare(BufferArena& arena)
+    {
+        float* channel[] { arena.getFloats(fillOffset) };
+        bufferToFill.setDataToReferTo(channel, 1, size.get());
+        
+        audioBufferFifo.prepare(arena);
         fifoIndex = 0;
         prepared.set(true);
     }
@@ -153,12 +254,25 @@ struct SingleChannelSampleFifo
     // Get Buffer
     //==============================================================================
     int getNumCompleteBuffersAvailable() const { return audioBufferFifo.getNumAvailableForReading(); }
+    int getNumBlocks() const { return audioBufferFifo.getNumItems(); }
     bool isPrepared() const { return prepared.get(); }
     int getSize() const { return size.get(); }
     
     //==============================================================================
     bool getAudioBuffer(BlockType& buf) { return audioBufferFifo.pull(buf); }                                   // Get Buffer
     
+    // Audio thread: forget the partly filled block, so a resumed tap starts clean
+    void restartBlock() { fifoIndex = 0; }
+    
+    // Reader: drop stale blocks left over from an earlier reader
+    void discardCompleteBuffers() { audioBufferFifo.discardAvailable(); }
+    
+    size_t getMemoryUsage() const
+    {
+        return audioBufferFifo.getMemoryUsage()
+             + (size_t) bufferToFill.getNumChannels() * (size_t) bufferToFill.getNumSamples() * sizeof(float);
+    }
+    
     
     
     
@@ -170,7 +284,8 @@ private:
     
     Channel channelToUse;
     int fifoIndex = 0;
-    Fifo<BlockType> audioBufferFifo;
+    size_t fillOffset = 0;
+    Fifo<BlockType, Capacity> audioBufferFifo;
     BlockType bufferToFill;
     juce::Atomic<bool> prepared = false;
     juce::Atomic<int> size = 0;
@@ -212,20 +327,27 @@ struct ChainSettings
     float lowCutFreq { 0 }, highCutFreq { 0 };
     
     Slope lowCutSlope {Slope::Slope_12}, highCutSlope {Slope::Slope_12};
+    
+    bool operator== (const ChainSettings& other) const
+    {
+        return peakFreq == other.peakFreq && peakGainInDecibels == other.peakGainInDecibels && peakQuality == other.peakQuality
+            && lowCutFreq == other.lowCutFreq && highCutFreq == other.highCutFreq
+            && lowCutSlope == other.lowCutSlope && highCutSlope == other.highCutSlope;
+    }
+    bool operator!= (const ChainSettings& other) const { return ! operator== (other); }
 };
 
 ChainSettings getChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
+// the side chain of the mid/side mode, the same bands with their own parameters
+ChainSettings getSideChainSettings(juce::AudioProcessorValueTreeState& apvts);
 
+// the dynamic mode of the peak band
+DynamicSettings getDynamicSettings(juce::AudioProcessorValueTreeState& apvts);
 
-// Using IIR DSP Filter MAKE FILTER
-
-
-using Filter = juce::dsp::IIR::Filter<float>;
 
-using CutFilter = juce::dsp::ProcessorChain<Filter, Filter, Filter, Filter>;
 
-using MonoChain = juce::dsp::ProcessorChain<CutFilter, Filter, CutFilter>;
+// The parameters drive the first three bands of the EQEngine
 
 enum ChainPositions
 {
@@ -234,71 +356,27 @@ enum ChainPositions
     HighCut
 };
 
-using Coefficients = Filter::CoefficientsPtr;
-void updateCoefficients(Coefficients& old, const Coefficients& replacements);
+BandSettings makeLowCutBand(const ChainSettings& chainSettings);
+BandSettings makePeakBand(const ChainSettings& chainSettings);
+BandSettings makeHighCutBand(const ChainSettings& chainSettings);
 
-Coefficients makePeakFilter (const ChainSettings& chainSetting, double sampleRate);
+// designs all three parameter bands into 'design'
+void setChainBands(EQDesign& design, const ChainSettings& chainSettings, double sampleRate, CoefficientStore* store = nullptr);
 
-template<int Index, typename ChainType, typename CoefficientsType>
-
-void update(ChainType& chain, const CoefficientsType& coefficients)
-{
-    updateCoefficients (chain.template get<Index>().coefficients, coefficients[Index]);
-    chain.template setBypassed<Index>(false);
-}
-
-template<typename ChainType, typename CoefficientsType>
-void updateCutFilter(ChainType& leftLowCut,
-                     const CoefficientsType& cutCoefficients,
-                     const Slope& lowCutSlope)
+//==============================================================================
+// Every coefficient of one ChainSettings at one sample rate. Designed on the message
+// thread and never modified afterwards, the audio thread only copies from it.
+struct ChainDesign : juce::ReferenceCountedObject
 {
+    using Ptr = juce::ReferenceCountedObjectPtr<ChainDesign>;
     
+    ChainDesign(const ChainSettings& settingsToUse, double sampleRateToUse, CoefficientStore* store = nullptr);
     
-    leftLowCut.template setBypassed<0>(true);
-    leftLowCut.template setBypassed<1>(true);
-    leftLowCut.template setBypassed<2>(true);
-    leftLowCut.template setBypassed<3>(true);
+    ChainSettings settings;
+    double sampleRate;
     
-    switch( lowCutSlope )
-    {
-            
-        case Slope_48:
-        {
-            update<3>(leftLowCut, cutCoefficients);
-            
-        }
-        case Slope_36:
-        {
-            update<2>(leftLowCut, cutCoefficients);
-        }
-        case Slope_24:
-        {
-            update<1>(leftLowCut, cutCoefficients);
-        }
-        case Slope_12:
-        {
-            update<0>(leftLowCut, cutCoefficients);
-        }
-            
-    }
-}
-
-inline auto makeLowCutFilter(const ChainSettings &chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(chainSettings.lowCutFreq,
-                                                                                       sampleRate,
-                                                                                       2 * (chainSettings.lowCutSlope +1));
-}
-
-inline auto makeHighCutFilter(const ChainSettings &chainSettings, double sampleRate)
-{
-    return juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(chainSettings.highCutFreq,
-                                                                                      sampleRate,
-                                                                                      2 * (chainSettings.highCutSlope +1));
-}
-
-void updateLowCutFilters(const ChainSettings& chainSettings);
-void updateHighCutFilters(const ChainSettings& chainSettings);
+    EQDesign coefficients;
+};
 
 
 
@@ -310,7 +388,8 @@ void updateHighCutFilters(const ChainSettings& chainSettings);
 //==============================================================================     //==============================================================================
 /**
 */
-class LAUTEQAudioProcessor  : public juce::AudioProcessor
+class LAUTEQAudioProcessor  : public juce::AudioProcessor,
+                              private juce::Timer
 {
 public:
     //==============================================================================
@@ -350,10 +429,30 @@ public:
     void setCurrentProgram (int index) override;
     const juce::String getProgramName (int index) override;
     void changeProgramName (int index, const juce::String& newName) override;
+    
+    // A/B compare. Each slot keeps its settings and their design for the current sample
+    // rate, switching crossfades to it without designing anything on the audio thread.
+    enum CompareSlot { SlotA, SlotB };
+    void selectCompareSlot(CompareSlot slot);
+    void copyToOtherCompareSlot();
+    CompareSlot getCompareSlot() const { return compareSlot; }
+    
+    // MIDI learn: the next controller that arrives drives the parameter (an index into the
+    // state parameters). Controller moves are applied to the filters at their exact sample
+    // position, the parameter and the host follow from the message thread.
+    void learnMidiController(int parameterIndex);
+    void clearMidiControllers();
+    juce::String getStateParameterName(int parameterIndex) const;
 
     //==============================================================================
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    // parameters in the binary state, see getStateInformation. The first
+    // numChainParameters are the ChainSettings, the dynamic peak band, the
+    // mid/side mode with its side chain and the test signal follow.
+    static constexpr int numStateParameters = 24;
+    static constexpr int numChainParameters = 7;
 
     
     // APVTS Create Parameter Function
@@ -371,12 +470,33 @@ public:
     //============================================================================== Creates a buffer with a specified number of channels and samples.
     using BlockType = juce::AudioBuffer<float>;
     
+    // samples per analyzer block, whatever the host's block size
+    static constexpr int analyzerBlockSize = 1024;
+    
+    // How far the editor can fall behind: analyzerFifoSeconds, which covers a tick of its
+    // idle frame rate with some to spare. The number of blocks follows the sample rate,
+    // up to 192 kHz. Beyond that new blocks are dropped until it catches up.
+    static constexpr double analyzerFifoSeconds = 0.15;
+    static constexpr int maxAnalyzerFifoBlocks = 32;
+    static int getNumAnalyzerFifoBlocks(double sampleRate);
+    
+    using AnalyzerFifo = SingleChannelSampleFifo<BlockType, maxAnalyzerFifoBlocks>;
+    
     /// Prepare FIFo // Acces to Class // make it eas to mak Pointer instences
     
     
     // Create Fixed Sizes Blocks in left and right channel
-    SingleChannelSampleFifo<BlockType> leftChannelFifo { Channel::Left };
-    SingleChannelSampleFifo<BlockType> rightChannelFifo { Channel::Right };
+    AnalyzerFifo leftChannelFifo { Channel::Left };
+    AnalyzerFifo rightChannelFifo { Channel::Right };
+    
+    // The channel fifos are only fed while something reads them. Every
+    // ResponseCurveComponent subscribes while it exists, with no editor open
+    // processBlock skips the tap completely.
+    void addAnalyzerSubscriber();
+    void removeAnalyzerSubscriber();
+    
+    // where the instance's sample buffers live, for the memory report
+    const BufferArena& getBufferArena() const { return bufferArena; }
     
     
     
@@ -385,17 +505,154 @@ private:
     
     
     
-    MonoChain leftChain, rightChain;
+    // shared by every instance in the process, see CoefficientStore
+    juce::SharedResourcePointer<CoefficientStore> coefficientStore;
+    
+    // two engines, the inactive one only runs while a design switch fades out
+    std::array<EQEngine, 2> engines;
+    int activeEngine = 0;
     
-    void updatePeakFilter(const ChainSettings& chainSettings);
+    void updatePeakFilter(const ChainSettings& chainSettings, int lane);
     
-    void updateLowCutFilters(const ChainSettings& chainSettings);
-    void updateHighCutFilters(const ChainSettings& chainSettings);
+    void updateLowCutFilters(const ChainSettings& chainSettings, int lane);
+    void updateHighCutFilters(const ChainSettings& chainSettings, int lane);
     
     
     void updateFilters();
+    void updateFilters(const ChainSettings& chainSettings);
+    void updateSideFilters(const ChainSettings& sideSettings);
+    void updateChangedBands(const ChainSettings& chainSettings, const ChainSettings& previous, int lane);
+    void processFilters(juce::dsp::AudioBlock<float>& block, int startSample);
+    
+    // parameters, design handovers and modes, once per controlInterval samples at most
+    static constexpr int controlInterval = DynamicEQ::controlInterval;
+    void updateControls();
+    int samplesUntilControlUpdate = 0;      // audio thread only
+    void processEngines(juce::dsp::AudioBlock<float>& block);
+    
+    ChainSettings appliedSettings;          // audio thread only, what the active chains are designed for
+    
+    //============================================================================== Offline
+    // Rendering offline (isNonRealtime) is the same signal path with less around it:
+    // no analyzer tap, so no FIFO copies here and no FFTs in the editor, and the channel
+    // pairs of a bus wider than stereo run on a few worker threads. The kernels are the
+    // same ones as live, they already are the fastest there are, so a render matches
+    // playback bit for bit. Blocks are taken as the host sends them, grouping them into
+    // bigger ones would need latency.
+    //
+    // Measured with a 3-band chain, 512-sample stereo blocks: about 14 us for the
+    // engine, and another 2.4 us for the tap that offline renders skip.
+    //
+    // The workers are one pool for the whole process, a host renders many tracks side by
+    // side and a pool per instance would put far more threads than cores on the machine.
+    // The pool starts its threads with the first offline block that uses it.
+    static constexpr int minSamplesForWorkers = 256;
+    
+    bool shouldUseWorkers(int numChannels, int numSamples) const;
+    
+    juce::SharedResourcePointer<ChannelWorkerPool> workerPool;
+    
+    //============================================================================== Mid/side
+    // In mid/side the parameter chain runs on the mid lane and the side chain on the
+    // other, linked stereo runs the parameter chain on both. Only on a stereo main bus:
+    // on a wider one every pair would be encoded, surrounds and LFE included, so mono
+    // and wide buses stay linked.
+    int getMainLane() const { return appliedMidSide ? 0 : EQEngine::allLanes; }
+    void startModeCrossfade(bool midSide, const ChainSettings& sideSettings);
+    
+    bool appliedMidSide = false;            // audio thread only
+    bool canUseMidSide = true;              // set in prepareToPlay, the main bus is stereo
+    ChainSettings appliedSideSettings;
+    
+    //============================================================================== Dynamic peak band
+    // The peak gain follows the detector every DynamicEQ::controlInterval samples,
+    // through EQEngine::setPeakGain, so the band is never fully redesigned for it.
+    void setDynamicPeakGain(float gainInDecibels);
+    
+    DynamicEQ dynamicEQ;
+    DynamicSettings dynamicSettings;        // audio thread only
+    
+    // the sidechain input of the current block, if the host feeds one
+    std::array<const float*, EQEngine::numLanes> sidechainChannels {};
+    int numSidechainChannels = 0;
+    
+    //============================================================================== Programs, A/B
+    // Message thread only: sets the parameters, then hands the matching design over.
+    // A design made here may be released here too, never on the audio thread.
+    void recallSettings(const ChainSettings& settings, ChainDesign::Ptr design);
+    void setChainSettings(const ChainSettings& settings);
+    ChainSettings getSnappedSettings(const ChainSettings& settings) const;
+    void startDesignCrossfade(const ChainDesign& design);
+    EQEngine& beginCrossfade();
+    
+    /*
+     The audio thread takes a design out of pendingDesign and copies from it in the same
+     updateControls call, without owning it. So when the next one is handed over:
+        - if the slot still holds the last one, it was never taken and can go;
+        - if the slot is empty, the last one was taken and may still be being copied
+          from, it is kept as takenDesign. The one taken before it is done with, the
+          audio thread finished that copy before it took another.
+     Every handover happens on the message thread (a program change from the audio
+     thread waits for the timer, see pendingProgram), so a released design is deleted
+     there. The lock is only for the pointers below and cheap when uncontended, designs
+     are released after it.
+     */
+    void handOverDesign(ChainDesign::Ptr design);
+    
+    std::atomic<ChainDesign*> pendingDesign { nullptr };
+    juce::Atomic<bool> designSwitchPending { false };
+    
+    ChainDesign::Ptr queuedDesign, takenDesign;
+    juce::SpinLock handOverLock;
+    
+    // designed in prepareToPlay, so a program change only hands one over
+    juce::ReferenceCountedArray<ChainDesign> programDesigns;
+    
+    juce::AudioBuffer<float> fadeBuffer;
+    
+    // the samples of the fade buffer and the analyzer fifos, in one block
+    BufferArena bufferArena;
+    int fadeLength = 0, fadeSamplesRemaining = 0;
+    
+    int currentProgram = 0;
+    std::atomic<int> pendingProgram { -1 };     // set off the message thread, applied by timerCallback
+    juce::StringArray programNames;
+    
+    struct CompareSlotState
+    {
+        ChainSettings settings;
+        ChainDesign::Ptr design;
+        bool filled = false;
+    };
+    
+    std::array<CompareSlotState, 2> compareSlots;
+    CompareSlot compareSlot = SlotA;
+    
+    std::array<juce::RangedAudioParameter*, numStateParameters> stateParameters;
+    
+    //============================================================================== MIDI learn
+    int getControllerTarget(int controllerNumber);                  // audio thread
+    void applyControllerValue(int parameterIndex, int controllerValue);
+    
+    std::array<std::atomic<int8_t>, 128> controllerTargets;
+    std::atomic<int> controllerToLearn { -1 };
+    
+    // The audio thread doesn't notify the host, it leaves the normalised value here and the
+    // timer sets the parameter from the message thread. Program changes go the same way.
+    void timerCallback() override;
+    
+    std::array<std::atomic<float>, numStateParameters> controllerValues;
+    std::array<std::atomic<bool>, numStateParameters> controllerValuePending;
+    
+    // The chain parameters as the control grid last acted on them. A controller moves the
+    // filters before its parameter catches up, that mustn't read as a change back.
+    ChainSettings lastParameterSettings;
+    
+    juce::Atomic<int> analyzerSubscribers { 0 };
+    bool analyzerTapActive = false;     // audio thread only
     
-    juce::dsp::Oscillator<float> osc;
+    // test signal in place of the input, see SignalGenerator
+    SignalGenerator generator;
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LAUTEQAudioProcessor)
 };
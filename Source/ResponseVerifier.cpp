@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+    ResponseVerifier.cpp
+
+  ==============================================================================
+*/
+
+#include "ResponseVerifier.h"
+#include <complex>
+
+namespace
+{
+    // H(e^jw) of every band in the design, in double
+    std::complex<double> evaluate(const EQDesign& design, double omega)
+    {
+        const auto z1 = std::polar(1.0, -omega);
+        const auto z2 = z1 * z1;
+
+        std::complex<double> response { 1.0, 0.0 };
+
+        for( int band = 0; band < EQDesign::maxBands; ++band )
+        {
+            for( int i = 0; i < design.getNumSections(band); ++i )
+            {
+                auto s = (size_t) (band * EQDesign::maxSectionsPerBand + i);
+
+                auto numerator = (double) design.b0[s] + (double) design.b1[s] * z1 + (double) design.b2[s] * z2;
+                auto denominator = 1.0 + (double) design.a1[s] * z1 + (double) design.a2[s] * z2;
+                response *= numerator / denominator;
+            }
+        }
+
+        return response;
+    }
+}
+
+juce::String ResponseCheck::describe() const
+{
+    juce::String text;
+    text << (passed ? "PASS" : "FAIL")
+         << ": max deviation " << juce::String(maxDeviationInDecibels, 4) << " dB"
+         << " at " << juce::String(frequencyOfMaxDeviation, 1) << " Hz"
+         << " (tolerance " << juce::String(toleranceInDecibels, 2) << " dB, "
+         << numBinsChecked << " bins)";
+    return text;
+}
+
+ResponseCheck ResponseVerifier::run(LAUTEQAudioProcessor& processor, float toleranceInDecibels)
+{
+    juce::MemoryBlock state;
+    processor.getStateInformation(state);
+
+    return run(state, processor.getSampleRate() > 0 ? processor.getSampleRate() : 48000.0, toleranceInDecibels);
+}
+
+ResponseCheck ResponseVerifier::run(const juce::MemoryBlock& state, double sampleRate, float toleranceInDecibels)
+{
+    const auto fftSize = 1 << fftOrder;
+
+    //============================================================================== the probe
+    auto probeOwner = std::make_unique<LAUTEQAudioProcessor>();
+    auto& probe = *probeOwner;
+
+    probe.setStateInformation(state.getData(), (int) state.getSize());
+
+    for( auto* id : { "Peak Dynamic", "Generator" } )
+        probe.apvts.getParameter(id)->setValueNotifyingHost(0.f);
+
+    probe.menuChoice = 0;
+    probe.mix = 0.f;
+
+    probe.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    probe.prepareToPlay(sampleRate, blockSize);
+
+    //============================================================================== impulse through processBlock
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    std::vector<float> left((size_t) fftSize * 2, 0.f), right((size_t) fftSize * 2, 0.f);
+
+    for( int start = 0; start < fftSize; start += blockSize )
+    {
+        buffer.clear();
+        if( start == 0 )
+            buffer.setSample(0, 0, 1.f);
+
+        probe.processBlock(buffer, midi);
+
+        std::copy(buffer.getReadPointer(0), buffer.getReadPointer(0) + blockSize, left.begin() + start);
+        std::copy(buffer.getReadPointer(1), buffer.getReadPointer(1) + blockSize, right.begin() + start);
+    }
+
+    probe.releaseResources();
+
+    juce::dsp::FFT fft(fftOrder);
+    fft.performRealOnlyForwardTransform(left.data(), true);
+    fft.performRealOnlyForwardTransform(right.data(), true);
+
+    //============================================================================== prediction
+    auto midSide = probe.apvts.getRawParameterValue("Mid Side")->load() > 0.5f;
+
+    EQDesign mid, side;
+    setChainBands(mid, getChainSettings(probe.apvts), sampleRate);
+    setChainBands(side, midSide ? getSideChainSettings(probe.apvts) : getChainSettings(probe.apvts), sampleRate);
+
+    ResponseCheck result;
+    result.toleranceInDecibels = toleranceInDecibels;
+
+    auto floorGain = juce::Decibels::decibelsToGain((double) floorInDecibels);
+
+    for( int bin = 1; bin < fftSize / 2; ++bin )
+    {
+        auto frequency = bin * sampleRate / fftSize;
+        if( frequency < 20.0 || frequency > 20000.0 )
+            continue;
+
+        auto omega = juce::MathConstants<double>::twoPi * bin / fftSize;
+        auto hMid = evaluate(mid, omega);
+        auto hSide = midSide ? evaluate(side, omega) : hMid;
+
+        // the impulse is on the left only: L = (M + S) / 2 ... in linked stereo S == M
+        const std::complex<double> predicted[2] { 0.5 * (hMid + hSide), 0.5 * (hMid - hSide) };
+        const std::complex<double> measured[2]
+        {
+            { left[(size_t) bin * 2], left[(size_t) bin * 2 + 1] },
+            { right[(size_t) bin * 2], right[(size_t) bin * 2 + 1] }
+        };
+
+        for( int channel = 0; channel < 2; ++channel )
+        {
+            auto expectedGain = std::abs(predicted[channel]);
+            if( expectedGain < floorGain )
+                continue;
+
+            auto deviation = (float) std::abs(juce::Decibels::gainToDecibels(std::abs(measured[channel]), -200.0)
+                                              - juce::Decibels::gainToDecibels(expectedGain, -200.0));
+            ++result.numBinsChecked;
+
+            if( deviation > result.maxDeviationInDecibels )
+            {
+                result.maxDeviationInDecibels = deviation;
+                result.frequencyOfMaxDeviation = (float) frequency;
+            }
+        }
+    }
+
+    result.passed = result.numBinsChecked > 0 && result.maxDeviationInDecibels <= toleranceInDecibels;
+
+    // the probe's timers run on the message thread, so that's where it goes away
+    if( ! juce::MessageManager::getInstance()->isThisTheMessageThread() )
+    {
+        std::shared_ptr<LAUTEQAudioProcessor> finished(std::move(probeOwner));
+        juce::MessageManager::callAsync([finished] {});
+    }
+
+    return result;
+}
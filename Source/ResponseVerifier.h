@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    ResponseVerifier.h
+
+    Checks the audio path against the analytic response curve.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+struct ResponseCheck
+{
+    bool passed = false;
+    float toleranceInDecibels = 0;
+    float maxDeviationInDecibels = 0;
+    float frequencyOfMaxDeviation = 0;
+    int numBinsChecked = 0;
+
+    juce::String describe() const;
+};
+
+//==============================================================================
+/*
+ Verification mode. A probe instance gets the processor's state, an impulse goes into
+ its left channel through processBlock, block by block like a host would do it, and the
+ FFT of both outputs is compared with the response predicted from the designs:
+ H on the left and nothing on the right in linked stereo, (Hmid + Hside) / 2 and
+ (Hmid - Hside) / 2 in mid/side.
+
+ Anything not linear is switched off in the probe (distortion, dynamic peak band, test
+ signal), so this checks the filter path itself: the engine, its kernels and the way
+ processBlock drives them. Bins where the prediction is below floorInDecibels are
+ skipped: deep in the stop band of a steep low cut the float recursion itself is off
+ by tenths of a dB (an 8th order 40 Hz cut reads 0.7 dB high at 20 Hz, -46 dB), which
+ says nothing about a kernel being right or wrong.
+
+ Allocates. The processor that is playing is only read, for its state and sample rate,
+ and that part has to happen on the message thread. The probe works from the copy, so
+ the second overload can run on any thread.
+ */
+class ResponseVerifier
+{
+public:
+    static constexpr int fftOrder = 16;
+    static constexpr int blockSize = 512;
+    static constexpr float defaultToleranceInDecibels = 0.1f;
+    static constexpr float floorInDecibels = -30.f;
+
+    static ResponseCheck run(LAUTEQAudioProcessor& processor, float toleranceInDecibels = defaultToleranceInDecibels);
+    static ResponseCheck run(const juce::MemoryBlock& state, double sampleRate, float toleranceInDecibels = defaultToleranceInDecibels);
+};
@@ -0,0 +1,383 @@
+/*
+  ==============================================================================
+
+    SIMDKernels.h
+
+    Small vectorised helpers shared by the analyzer, the response curve and the
+    EQ engine.
+    Each kernel has an SSE2 path, a NEON path and a scalar fallback that give
+    the same results, so the build picks whatever the target supports.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define LAUTEQ_SIMD_SSE2 1
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+ #include <arm_neon.h>
+ #define LAUTEQ_SIMD_NEON 1
+#endif
+
+namespace SIMDKernels
+{
+
+//==============================================================================
+/*
+ Fast log2 approximation.
+
+ x = m * 2^e with m in [1, 2) is split from the float bits, and log2(m) is taken
+ from a 4th order polynomial in (m - 1) fitted against log2 over [1, 2).
+ Max abs error is 1.03e-4 in log2, i.e. 6.2e-4 dB for amplitudes (20 * log10)
+ and 3.1e-4 dB for powers (10 * log10). The analyzer maps 48 dB onto roughly
+ a hundred pixels, so that is about three orders of magnitude below what can
+ be seen. p(0) == 0 and p(1) == 1 within the same error, so the curve stays
+ continuous across octave boundaries.
+ */
+namespace Log2Poly
+{
+    constexpr float c1 =  1.4390168862746788f;
+    constexpr float c2 = -0.6799621664308461f;
+    constexpr float c3 =  0.32563468980594407f;
+    constexpr float c4 = -0.08479284480850868f;
+}
+
+/** dB per octave of gain: 20 * log10(2) for amplitudes, 10 * log10(2) for powers. */
+constexpr float amplitudeDecibelsPerLog2 = 6.0205999132796239f;
+constexpr float powerDecibelsPerLog2     = 3.0102999566398120f;
+
+inline float fastLog2 (float x) noexcept
+{
+    uint32_t bits;
+    std::memcpy (&bits, &x, sizeof (bits));
+
+    auto e = (int32_t) ((bits >> 23) & 0xff) - 127;
+    bits = (bits & 0x007fffffu) | 0x3f800000u;
+
+    float m;
+    std::memcpy (&m, &bits, sizeof (m));
+
+    auto t = m - 1.f;
+    auto p = (((Log2Poly::c4 * t + Log2Poly::c3) * t + Log2Poly::c2) * t + Log2Poly::c1) * t;
+    return (float) e + p;
+}
+
+//==============================================================================
+namespace detail
+{
+    /** Scalar version of the fused kernel, also used for the tail of the vector loops. */
+    inline float scaleAndConvert (float v, float gain, float dBPerLog2, float negativeInfinity) noexcept
+    {
+        v *= gain;
+
+        uint32_t bits;
+        std::memcpy (&bits, &v, sizeof (bits));
+
+        // NaN, inf, zero and negative values all end up at the floor, the same
+        // as the old isinf/isnan check followed by gainToDecibels.
+        const bool finite = (bits & 0x7f800000u) != 0x7f800000u;
+        if( ! finite || ! (v > 0.f) )
+            return negativeInfinity;
+
+        auto db = fastLog2 (v) * dBPerLog2;
+        return db > negativeInfinity ? db : negativeInfinity;
+    }
+}
+
+/**
+ Scales 'numValues' magnitudes by 'gain' and converts them to decibels in place,
+ clamping at 'negativeInfinity'. Non-finite inputs end up at the floor.
+
+ This is the fused form of the normalise loop followed by
+ juce::Decibels::gainToDecibels() that the analyzer used to run per bin.
+ Pass powerDecibelsPerLog2 when 'data' holds squared magnitudes.
+ */
+inline void gainToDecibels (float* data,
+                            int numValues,
+                            float gain,
+                            float negativeInfinity,
+                            float dBPerLog2 = amplitudeDecibelsPerLog2) noexcept
+{
+    int i = 0;
+
+   #if LAUTEQ_SIMD_SSE2
+    const auto gainV  = _mm_set1_ps (gain);
+    const auto scaleV = _mm_set1_ps (dBPerLog2);
+    const auto floorV = _mm_set1_ps (negativeInfinity);
+    const auto zeroV  = _mm_setzero_ps();
+    const auto oneV   = _mm_set1_ps (1.f);
+    const auto expMask  = _mm_set1_epi32 (0x7f800000);
+    const auto mantMask = _mm_set1_epi32 (0x007fffff);
+    const auto oneBits  = _mm_set1_epi32 (0x3f800000);
+    const auto bias     = _mm_set1_epi32 (127);
+    const auto c1 = _mm_set1_ps (Log2Poly::c1), c2 = _mm_set1_ps (Log2Poly::c2);
+    const auto c3 = _mm_set1_ps (Log2Poly::c3), c4 = _mm_set1_ps (Log2Poly::c4);
+
+    for( ; i + 4 <= numValues; i += 4 )
+    {
+        auto v = _mm_mul_ps (_mm_loadu_ps (data + i), gainV);
+        auto bits = _mm_castps_si128 (v);
+        auto expBits = _mm_and_si128 (bits, expMask);
+
+        auto valid = _mm_and_ps (_mm_cmpgt_ps (v, zeroV),
+                                 _mm_castsi128_ps (_mm_cmplt_epi32 (expBits, expMask)));
+
+        auto e = _mm_cvtepi32_ps (_mm_sub_epi32 (_mm_srli_epi32 (expBits, 23), bias));
+        auto m = _mm_castsi128_ps (_mm_or_si128 (_mm_and_si128 (bits, mantMask), oneBits));
+        auto t = _mm_sub_ps (m, oneV);
+
+        auto p = _mm_add_ps (_mm_mul_ps (c4, t), c3);
+        p = _mm_add_ps (_mm_mul_ps (p, t), c2);
+        p = _mm_add_ps (_mm_mul_ps (p, t), c1);
+        p = _mm_mul_ps (p, t);
+
+        auto db = _mm_max_ps (_mm_mul_ps (_mm_add_ps (e, p), scaleV), floorV);
+        db = _mm_or_ps (_mm_and_ps (valid, db), _mm_andnot_ps (valid, floorV));
+
+        _mm_storeu_ps (data + i, db);
+    }
+   #elif LAUTEQ_SIMD_NEON
+    const auto gainV  = vdupq_n_f32 (gain);
+    const auto scaleV = vdupq_n_f32 (dBPerLog2);
+    const auto floorV = vdupq_n_f32 (negativeInfinity);
+    const auto zeroV  = vdupq_n_f32 (0.f);
+    const auto oneV   = vdupq_n_f32 (1.f);
+    const auto expMask  = vdupq_n_u32 (0x7f800000u);
+    const auto mantMask = vdupq_n_u32 (0x007fffffu);
+    const auto oneBits  = vdupq_n_u32 (0x3f800000u);
+    const auto bias     = vdupq_n_s32 (127);
+    const auto c1 = vdupq_n_f32 (Log2Poly::c1), c2 = vdupq_n_f32 (Log2Poly::c2);
+    const auto c3 = vdupq_n_f32 (Log2Poly::c3), c4 = vdupq_n_f32 (Log2Poly::c4);
+
+    for( ; i + 4 <= numValues; i += 4 )
+    {
+        auto v = vmulq_f32 (vld1q_f32 (data + i), gainV);
+        auto bits = vreinterpretq_u32_f32 (v);
+        auto expBits = vandq_u32 (bits, expMask);
+
+        auto valid = vandq_u32 (vcgtq_f32 (v, zeroV), vcltq_u32 (expBits, expMask));
+
+        auto e = vcvtq_f32_s32 (vsubq_s32 (vreinterpretq_s32_u32 (vshrq_n_u32 (expBits, 23)), bias));
+        auto m = vreinterpretq_f32_u32 (vorrq_u32 (vandq_u32 (bits, mantMask), oneBits));
+        auto t = vsubq_f32 (m, oneV);
+
+        auto p = vmlaq_f32 (c3, c4, t);
+        p = vmlaq_f32 (c2, p, t);
+        p = vmlaq_f32 (c1, p, t);
+        p = vmulq_f32 (p, t);
+
+        auto db = vmaxq_f32 (vmulq_f32 (vaddq_f32 (e, p), scaleV), floorV);
+        db = vbslq_f32 (valid, db, floorV);
+
+        vst1q_f32 (data + i, db);
+    }
+   #endif
+
+    for( ; i < numValues; ++i )
+        data[i] = detail::scaleAndConvert (data[i], gain, dBPerLog2, negativeInfinity);
+}
+
+//==============================================================================
+/**
+ Multiplies 'power' by |H(e^jw)|^2 of one biquad section for 'numValues' frequencies.
+
+ cos1/sin1 hold cos(w)/sin(w) for each frequency and cos2/sin2 the same for 2w, so the
+ evaluation is nothing but multiply-adds and one divide, with no trig or complex maths.
+ b0, b1, b2 and a1, a2 are the normalised coefficients (a0 == 1); pass 0 for b2 and a2
+ to evaluate a first order section.
+ */
+inline void accumulateBiquadPower (float* power,
+                                   const float* cos1, const float* sin1,
+                                   const float* cos2, const float* sin2,
+                                   int numValues,
+                                   float b0, float b1, float b2,
+                                   float a1, float a2) noexcept
+{
+    int i = 0;
+
+   #if LAUTEQ_SIMD_SSE2
+    const auto b0V = _mm_set1_ps (b0), b1V = _mm_set1_ps (b1), b2V = _mm_set1_ps (b2);
+    const auto a1V = _mm_set1_ps (a1), a2V = _mm_set1_ps (a2);
+    const auto oneV = _mm_set1_ps (1.f);
+
+    for( ; i + 4 <= numValues; i += 4 )
+    {
+        auto c1 = _mm_loadu_ps (cos1 + i), s1 = _mm_loadu_ps (sin1 + i);
+        auto c2 = _mm_loadu_ps (cos2 + i), s2 = _mm_loadu_ps (sin2 + i);
+
+        auto nr = _mm_add_ps (b0V, _mm_add_ps (_mm_mul_ps (b1V, c1), _mm_mul_ps (b2V, c2)));
+        auto ni = _mm_add_ps (_mm_mul_ps (b1V, s1), _mm_mul_ps (b2V, s2));
+        auto dr = _mm_add_ps (oneV, _mm_add_ps (_mm_mul_ps (a1V, c1), _mm_mul_ps (a2V, c2)));
+        auto di = _mm_add_ps (_mm_mul_ps (a1V, s1), _mm_mul_ps (a2V, s2));
+
+        auto n = _mm_add_ps (_mm_mul_ps (nr, nr), _mm_mul_ps (ni, ni));
+        auto d = _mm_add_ps (_mm_mul_ps (dr, dr), _mm_mul_ps (di, di));
+
+        _mm_storeu_ps (power + i, _mm_mul_ps (_mm_loadu_ps (power + i), _mm_div_ps (n, d)));
+    }
+   #elif LAUTEQ_SIMD_NEON && defined (__aarch64__)
+    const auto b0V = vdupq_n_f32 (b0), b1V = vdupq_n_f32 (b1), b2V = vdupq_n_f32 (b2);
+    const auto a1V = vdupq_n_f32 (a1), a2V = vdupq_n_f32 (a2);
+    const auto oneV = vdupq_n_f32 (1.f);
+
+    for( ; i + 4 <= numValues; i += 4 )
+    {
+        auto c1 = vld1q_f32 (cos1 + i), s1 = vld1q_f32 (sin1 + i);
+        auto c2 = vld1q_f32 (cos2 + i), s2 = vld1q_f32 (sin2 + i);
+
+        auto nr = vmlaq_f32 (vmlaq_f32 (b0V, b1V, c1), b2V, c2);
+        auto ni = vmlaq_f32 (vmulq_f32 (b1V, s1), b2V, s2);
+        auto dr = vmlaq_f32 (vmlaq_f32 (oneV, a1V, c1), a2V, c2);
+        auto di = vmlaq_f32 (vmulq_f32 (a1V, s1), a2V, s2);
+
+        auto n = vmlaq_f32 (vmulq_f32 (nr, nr), ni, ni);
+        auto d = vmlaq_f32 (vmulq_f32 (dr, dr), di, di);
+
+        vst1q_f32 (power + i, vmulq_f32 (vld1q_f32 (power + i), vdivq_f32 (n, d)));
+    }
+   #endif
+
+    for( ; i < numValues; ++i )
+    {
+        auto nr = b0 + b1 * cos1[i] + b2 * cos2[i];
+        auto ni = b1 * sin1[i] + b2 * sin2[i];
+        auto dr = 1.f + a1 * cos1[i] + a2 * cos2[i];
+        auto di = a1 * sin1[i] + a2 * sin2[i];
+
+        power[i] *= (nr * nr + ni * ni) / (dr * dr + di * di);
+    }
+}
+
+//==============================================================================
+/** One biquad section for two lanes, [0] is left (or mid) and [1] right (or side). */
+struct BiquadPair
+{
+    float b0[2], b1[2], b2[2], a1[2], a2[2];
+};
+
+/**
+ Runs one biquad section (transposed direct form II, a0 == 1) over two channels in place,
+ each lane with its own coefficients and state, both lanes in one vector register.
+
+ encodeMidSide turns the input into mid and side first, M = (L + R) / 2, S = (L - R) / 2,
+ decodeMidSide turns the output back into L = M + S, R = M - S. Put them on the first and
+ last section of a chain and mid/side costs no pass of its own. z1 and z2 hold the state
+ of both lanes.
+ */
+template <bool encodeMidSide, bool decodeMidSide>
+inline void processBiquadPair (float* left, float* right, int numSamples,
+                               const BiquadPair& c, float* z1, float* z2) noexcept
+{
+   #if LAUTEQ_SIMD_SSE2
+    const auto b0V = _mm_setr_ps (c.b0[0], c.b0[1], 0.f, 0.f);
+    const auto b1V = _mm_setr_ps (c.b1[0], c.b1[1], 0.f, 0.f);
+    const auto b2V = _mm_setr_ps (c.b2[0], c.b2[1], 0.f, 0.f);
+    const auto a1V = _mm_setr_ps (c.a1[0], c.a1[1], 0.f, 0.f);
+    const auto a2V = _mm_setr_ps (c.a2[0], c.a2[1], 0.f, 0.f);
+
+    const auto halfV = _mm_setr_ps (0.5f, 0.5f, 0.f, 0.f);
+    const auto encodeV = _mm_setr_ps (0.5f, -0.5f, 0.f, 0.f);
+    const auto decodeV = _mm_setr_ps (1.f, -1.f, 0.f, 0.f);
+
+    auto z1V = _mm_setr_ps (z1[0], z1[1], 0.f, 0.f);
+    auto z2V = _mm_setr_ps (z2[0], z2[1], 0.f, 0.f);
+
+    for( int i = 0; i < numSamples; ++i )
+    {
+        auto x = _mm_unpacklo_ps (_mm_load_ss (left + i), _mm_load_ss (right + i));
+
+        if constexpr (encodeMidSide)
+        {
+            auto swapped = _mm_shuffle_ps (x, x, _MM_SHUFFLE (3, 2, 0, 1));
+            x = _mm_add_ps (_mm_mul_ps (x, encodeV), _mm_mul_ps (swapped, halfV));
+        }
+
+        auto y = _mm_add_ps (_mm_mul_ps (b0V, x), z1V);
+        z1V = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (b1V, x), _mm_mul_ps (a1V, y)), z2V);
+        z2V = _mm_sub_ps (_mm_mul_ps (b2V, x), _mm_mul_ps (a2V, y));
+
+        if constexpr (decodeMidSide)
+            y = _mm_add_ps (_mm_mul_ps (y, decodeV), _mm_shuffle_ps (y, y, _MM_SHUFFLE (3, 2, 0, 1)));
+
+        _mm_store_ss (left + i, y);
+        _mm_store_ss (right + i, _mm_shuffle_ps (y, y, _MM_SHUFFLE (1, 1, 1, 1)));
+    }
+
+    float state[4];
+    _mm_storeu_ps (state, z1V);
+    z1[0] = state[0]; z1[1] = state[1];
+    _mm_storeu_ps (state, z2V);
+    z2[0] = state[0]; z2[1] = state[1];
+   #elif LAUTEQ_SIMD_NEON
+    const auto b0V = vld1_f32 (c.b0), b1V = vld1_f32 (c.b1), b2V = vld1_f32 (c.b2);
+    const auto a1V = vld1_f32 (c.a1), a2V = vld1_f32 (c.a2);
+
+    const float encode[2] { 0.5f, -0.5f }, decode[2] { 1.f, -1.f };
+    const auto halfV = vdup_n_f32 (0.5f), encodeV = vld1_f32 (encode), decodeV = vld1_f32 (decode);
+
+    auto z1V = vld1_f32 (z1), z2V = vld1_f32 (z2);
+
+    for( int i = 0; i < numSamples; ++i )
+    {
+        auto x = vset_lane_f32 (right[i], vdup_n_f32 (left[i]), 1);
+
+        if constexpr (encodeMidSide)
+            x = vmla_f32 (vmul_f32 (x, encodeV), vrev64_f32 (x), halfV);
+
+        auto y = vmla_f32 (z1V, b0V, x);
+        z1V = vadd_f32 (vmls_f32 (vmul_f32 (b1V, x), a1V, y), z2V);
+        z2V = vmls_f32 (vmul_f32 (b2V, x), a2V, y);
+
+        if constexpr (decodeMidSide)
+            y = vmla_f32 (vrev64_f32 (y), y, decodeV);
+
+        left[i] = vget_lane_f32 (y, 0);
+        right[i] = vget_lane_f32 (y, 1);
+    }
+
+    vst1_f32 (z1, z1V);
+    vst1_f32 (z2, z2V);
+   #else
+    auto z1L = z1[0], z2L = z2[0], z1R = z1[1], z2R = z2[1];
+
+    for( int i = 0; i < numSamples; ++i )
+    {
+        auto xL = left[i], xR = right[i];
+
+        if constexpr (encodeMidSide)
+        {
+            auto mid = 0.5f * (xL + xR);
+            xR = 0.5f * (xL - xR);
+            xL = mid;
+        }
+
+        auto yL = c.b0[0] * xL + z1L;
+        z1L = c.b1[0] * xL - c.a1[0] * yL + z2L;
+        z2L = c.b2[0] * xL - c.a2[0] * yL;
+
+        auto yR = c.b0[1] * xR + z1R;
+        z1R = c.b1[1] * xR - c.a1[1] * yR + z2R;
+        z2R = c.b2[1] * xR - c.a2[1] * yR;
+
+        if constexpr (decodeMidSide)
+        {
+            auto side = yR;
+            yR = yL - side;
+            yL = yL + side;
+        }
+
+        left[i] = yL;
+        right[i] = yR;
+    }
+
+    z1[0] = z1L; z2[0] = z2L;
+    z1[1] = z1R; z2[1] = z2R;
+   #endif
+}
+
+} // namespace SIMDKernels
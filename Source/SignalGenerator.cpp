@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    SignalGenerator.cpp
+
+  ==============================================================================
+*/
+
+#include "SignalGenerator.h"
+
+const std::array<float, SignalGenerator::tableSize + 1>& SignalGenerator::getSineTable()
+{
+    // one period plus a guard point, so interpolation never wraps
+    static const auto sineTable = []
+    {
+        std::array<float, tableSize + 1> values;
+        for( int i = 0; i <= tableSize; ++i )
+            values[(size_t) i] = (float) std::sin(juce::MathConstants<double>::twoPi * i / tableSize);
+        return values;
+    }();
+
+    return sineTable;
+}
+
+void SignalGenerator::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    table = &getSineTable();
+
+    // at rates where 20 kHz is too close to Nyquist the sweep stops short of it instead of aliasing
+    auto endFrequency = juce::jmin((double) sweepEndFrequency, sweepEndRatio * sampleRate);
+    sweepEndIncrement = endFrequency / sampleRate;
+    sweepFactor = std::pow(endFrequency / sweepStartFrequency, 1.0 / (sweepSeconds * sampleRate));
+
+    reset();
+}
+
+void SignalGenerator::reset() noexcept
+{
+    phase = 0;
+    sweepIncrement = sweepStartFrequency / sampleRate;
+    pinkState.fill(0.f);
+    impulseCountdown = 0;
+}
+
+void SignalGenerator::setType(GeneratorType newType) noexcept
+{
+    // every signal starts from its beginning, a sweep from the bottom
+    if( newType != type )
+        reset();
+
+    type = newType;
+}
+
+float SignalGenerator::readTable(double phaseToRead) const noexcept
+{
+    auto position = phaseToRead * tableSize;
+    auto index = (int) position;
+    auto fraction = (float) (position - index);
+
+    auto& values = *table;
+    return values[(size_t) index] + fraction * (values[(size_t) index + 1] - values[(size_t) index]);
+}
+
+float SignalGenerator::nextWhite() noexcept
+{
+    // xorshift32, top 24 bits to [-1, 1)
+    noiseState ^= noiseState << 13;
+    noiseState ^= noiseState >> 17;
+    noiseState ^= noiseState << 5;
+
+    return (float) (noiseState >> 8) * (2.f / 16777216.f) - 1.f;
+}
+
+void SignalGenerator::process(float* const* channels, int numChannels, int numSamples) noexcept
+{
+    if( type == GeneratorOff || numChannels <= 0 || table == nullptr )
+        return;
+
+    auto* out = channels[0];
+
+    switch( type )
+    {
+        case GeneratorSine:
+        {
+            auto increment = juce::jlimit(0.0, 0.5, frequency / sampleRate);
+
+            for( int i = 0; i < numSamples; ++i )
+            {
+                out[i] = level * readTable(phase);
+
+                phase += increment;
+                if( phase >= 1.0 )
+                    phase -= 1.0;
+            }
+            break;
+        }
+        case GeneratorSweep:
+        {
+            // exponential: the increment grows by the same factor every sample
+            for( int i = 0; i < numSamples; ++i )
+            {
+                out[i] = level * readTable(phase);
+
+                phase += sweepIncrement;
+                if( phase >= 1.0 )
+                    phase -= 1.0;
+
+                sweepIncrement *= sweepFactor;
+                if( sweepIncrement > sweepEndIncrement )
+                    sweepIncrement = sweepStartFrequency / sampleRate;
+            }
+            break;
+        }
+        case GeneratorWhiteNoise:
+        {
+            for( int i = 0; i < numSamples; ++i )
+                out[i] = level * nextWhite();
+            break;
+        }
+        case GeneratorPinkNoise:
+        {
+            // Paul Kellet's refined pink filter, about +-0.05 dB above 9 Hz
+            auto& b = pinkState;
+
+            for( int i = 0; i < numSamples; ++i )
+            {
+                auto white = nextWhite();
+
+                b[0] = 0.99886f * b[0] + white * 0.0555179f;
+                b[1] = 0.99332f * b[1] + white * 0.0750759f;
+                b[2] = 0.96900f * b[2] + white * 0.1538520f;
+                b[3] = 0.86650f * b[3] + white * 0.3104856f;
+                b[4] = 0.55000f * b[4] + white * 0.5329522f;
+                b[5] = -0.7616f * b[5] - white * 0.0168980f;
+
+                auto pink = b[0] + b[1] + b[2] + b[3] + b[4] + b[5] + b[6] + white * 0.5362f;
+                b[6] = white * 0.115926f;
+
+                // the filter has a gain of roughly 10 (+20 dB) in its passband
+                out[i] = level * 0.11f * pink;
+            }
+            break;
+        }
+        case GeneratorImpulse:
+        {
+            juce::FloatVectorOperations::clear(out, numSamples);
+
+            auto period = juce::jmax(1, juce::roundToInt(impulsePeriodSeconds * sampleRate));
+
+            for( int i = impulseCountdown; i < numSamples; i += period )
+                out[i] = level;
+
+            impulseCountdown = (impulseCountdown - numSamples) % period;
+            if( impulseCountdown < 0 )
+                impulseCountdown += period;
+            break;
+        }
+        case GeneratorOff:
+            break;
+    }
+
+    for( int channel = 1; channel < numChannels; ++channel )
+        juce::FloatVectorOperations::copy(channels[channel], out, numSamples);
+}
@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    SignalGenerator.h
+
+    Test signals that can replace the EQ input.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+enum GeneratorType
+{
+    GeneratorOff,
+    GeneratorSine,
+    GeneratorSweep,
+    GeneratorWhiteNoise,
+    GeneratorPinkNoise,
+    GeneratorImpulse
+};
+
+//==============================================================================
+/*
+ Sine and sweep read a shared wavetable with linear interpolation, the sweep moves its
+ phase increment by a constant factor per sample, so neither calls std::sin per sample.
+ White noise is a xorshift generator, pink noise that same white through Paul Kellet's
+ filter, the impulse a single full scale sample once per impulsePeriodSeconds.
+
+ Everything is set up in prepare, process never allocates.
+ */
+class SignalGenerator
+{
+public:
+    static constexpr int tableSize = 2048;
+    static constexpr float sweepStartFrequency = 20.f;
+    static constexpr float sweepEndFrequency = 20000.f;     // or sweepEndRatio of the rate, if lower
+    static constexpr double sweepEndRatio = 0.45;
+    static constexpr double sweepSeconds = 10.0;
+    static constexpr double impulsePeriodSeconds = 1.0;
+
+    void prepare(double newSampleRate);
+    void reset() noexcept;
+
+    void setType(GeneratorType newType) noexcept;
+    void setFrequency(float newFrequency) noexcept { frequency = newFrequency; }
+    void setLevel(float levelInDecibels) noexcept { level = juce::Decibels::decibelsToGain(levelInDecibels); }
+
+    GeneratorType getType() const { return type; }
+
+    // replaces the first numChannels channels with the signal, the same on all of them
+    void process(float* const* channels, int numChannels, int numSamples) noexcept;
+
+private:
+    float nextWhite() noexcept;
+    float readTable(double phaseToRead) const noexcept;
+
+    static const std::array<float, tableSize + 1>& getSineTable();
+
+    const std::array<float, tableSize + 1>* table = nullptr;
+
+    GeneratorType type = GeneratorOff;
+    double sampleRate = 44100.0;
+    float frequency = 1000.f, level = 0.125f;
+
+    double phase = 0, sweepIncrement = 0, sweepEndIncrement = 0.5, sweepFactor = 1;
+    uint32_t noiseState = 0x12345678u;
+    std::array<float, 7> pinkState {};
+    int impulseCountdown = 0;
+};
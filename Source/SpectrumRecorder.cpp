@@ -0,0 +1,403 @@
+/*
+  ==============================================================================
+
+    SpectrumRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumRecorder.h"
+
+//==============================================================================
+// IEEE 754 binary16, round to nearest even. Spectrum values are small dB numbers,
+// so the denormal path only matters for completeness.
+
+uint16_t SpectrumFile::floatToHalf(float value) noexcept
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    auto sign = (uint16_t) ((bits >> 16) & 0x8000u);
+    auto exponent = (int32_t) ((bits >> 23) & 0xff);
+    auto mantissa = bits & 0x007fffffu;
+
+    if( exponent == 0xff )                                          // inf / NaN
+        return (uint16_t) (sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+
+    exponent = exponent - 127 + 15;
+
+    if( exponent >= 0x1f )                                          // too large
+        return (uint16_t) (sign | 0x7c00u);
+
+    if( exponent <= 0 )                                             // denormal or zero
+    {
+        if( exponent < -10 )
+            return sign;
+
+        mantissa |= 0x00800000u;
+        auto shift = (uint32_t) (14 - exponent);
+        auto half = mantissa >> shift;
+        auto remainder = mantissa & ((1u << shift) - 1u);
+        auto halfway = 1u << (shift - 1u);
+
+        if( remainder > halfway || (remainder == halfway && (half & 1u)) )
+            ++half;
+
+        return (uint16_t) (sign | half);
+    }
+
+    auto half = (uint32_t) ((exponent << 10) | (mantissa >> 13));
+    auto remainder = mantissa & 0x1fffu;
+
+    if( remainder > 0x1000u || (remainder == 0x1000u && (half & 1u)) )
+        ++half;                                                     // may carry into the exponent, which is still correct
+
+    return (uint16_t) (sign | half);
+}
+
+float SpectrumFile::halfToFloat(uint16_t half) noexcept
+{
+    auto sign = (uint32_t) (half & 0x8000u) << 16;
+    auto exponent = (int32_t) ((half >> 10) & 0x1f);
+    auto mantissa = (uint32_t) (half & 0x3ffu);
+
+    uint32_t bits;
+
+    if( exponent == 0x1f )
+    {
+        bits = sign | 0x7f800000u | (mantissa << 13);
+    }
+    else if( exponent == 0 )
+    {
+        if( mantissa == 0 )
+        {
+            bits = sign;
+        }
+        else
+        {
+            // normalise the denormal
+            exponent = 1;
+            while( (mantissa & 0x400u) == 0 )
+            {
+                mantissa <<= 1;
+                --exponent;
+            }
+
+            bits = sign | ((uint32_t) (exponent - 15 + 127) << 23) | ((mantissa & 0x3ffu) << 13);
+        }
+    }
+    else
+    {
+        bits = sign | ((uint32_t) (exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//============================================================================== WRITER //==============================================================================
+
+SpectrumRecorder::SpectrumRecorder() : juce::Thread("Spectrum Recorder")
+{
+}
+
+SpectrumRecorder::~SpectrumRecorder()
+{
+    stop();
+}
+
+bool SpectrumRecorder::start(const juce::File& file,
+                             SpectrumFile::Encoding encoding,
+                             float floorDecibels,
+                             float ceilingDecibels)
+{
+    stop();
+
+    fileHeader = {};
+    std::memcpy(fileHeader.magic, SpectrumFile::magic, sizeof(fileHeader.magic));
+    fileHeader.version = SpectrumFile::currentVersion;
+    fileHeader.encoding = encoding;
+    fileHeader.floorDecibels = floorDecibels;
+    fileHeader.ceilingDecibels = ceilingDecibels;
+
+    // only ever append to a recording made with the same settings
+    uint16_t existingVersion = SpectrumFile::currentVersion;
+
+    if( file.existsAsFile() && file.getSize() > 0 )
+    {
+        SpectrumFile::FileHeader existing;
+        juce::FileInputStream input(file);
+
+        if( input.failedToOpen() || input.read(&existing, sizeof(existing)) != (int) sizeof(existing) )
+            return false;
+
+        existingVersion = existing.version;
+
+        if( std::memcmp(existing.magic, SpectrumFile::magic, sizeof(existing.magic)) != 0
+            || existing.version == 0 || existing.version > fileHeader.version
+            || existing.encoding != fileHeader.encoding
+            || existing.floorDecibels != fileHeader.floorDecibels
+            || existing.ceilingDecibels != fileHeader.ceilingDecibels )
+            return false;
+    }
+
+    file.getParentDirectory().createDirectory();
+
+    // FileOutputStream opens existing files at their end
+    stream = std::make_unique<juce::FileOutputStream>(file);
+    if( stream->failedToOpen() )
+    {
+        stream.reset();
+        return false;
+    }
+
+    if( stream->getPosition() == 0 )
+    {
+        stream->write(&fileHeader, sizeof(fileHeader));
+    }
+    else if( existingVersion < fileHeader.version )
+    {
+        // a version 1 file reads the same as version 2, it only gains session records
+        auto end = stream->getPosition();
+        stream->setPosition(offsetof(SpectrumFile::FileHeader, version));
+        stream->write(&fileHeader.version, sizeof(fileHeader.version));
+        stream->setPosition(end);
+    }
+
+    // the frames are timed from here, this record says when that was
+    startTimeMs = juce::Time::getMillisecondCounterHiRes();
+
+    SpectrumFile::SessionHeader session {};
+    session.recordSize = sizeof(session);
+    session.startTimeSeconds = (double) juce::Time::currentTimeMillis() * 0.001;
+    session.recordType = SpectrumFile::SessionRecord;
+    stream->write(&session, sizeof(session));
+
+    // worst case slot: every trace at the largest fft, as half floats
+    for( auto& slot : slots )
+        slot.payload.allocate((size_t) maxTraces * maxBins * sizeof(uint16_t) + 8, true);
+
+    ringFifo.reset();
+    droppedFrames.set(0);
+
+    recording.set(true);
+    startThread();
+    return true;
+}
+
+void SpectrumRecorder::stop()
+{
+    if( ! recording.get() )
+        return;
+
+    recording.set(false);
+
+    // the thread drains whatever is still queued before it exits
+    signalThreadShouldExit();
+    dataReady.signal();
+    stopThread(4000);
+
+    stream.reset();
+
+    for( auto& slot : slots )
+        slot.payload.free();
+}
+
+void SpectrumRecorder::pushFrame(const float* const* traces, int numTraces, int numBins, double sampleRate, int fftOrder)
+{
+    if( ! recording.get() )
+        return;
+
+    numTraces = juce::jlimit(0, maxTraces, numTraces);
+    numBins = juce::jlimit(0, maxBins, numBins);
+
+    {
+        auto write = ringFifo.write(1);
+        if( write.blockSize1 == 0 )
+        {
+            ++droppedFrames;
+            return;
+        }
+
+        auto& slot = slots[(size_t) write.startIndex1];
+        auto halfFloat = fileHeader.encoding == SpectrumFile::HalfFloat;
+        auto payloadSize = (size_t) numTraces * (size_t) numBins * (halfFloat ? sizeof(uint16_t) : sizeof(uint8_t));
+        auto paddedSize = (payloadSize + 7) & ~(size_t) 7;
+
+        auto& header = slot.header;
+        header.recordSize = (uint32_t) (sizeof(SpectrumFile::FrameHeader) + paddedSize);
+        header.numBins = (uint32_t) numBins;
+        header.timestampSeconds = (juce::Time::getMillisecondCounterHiRes() - startTimeMs) * 0.001;
+        header.sampleRate = (float) sampleRate;
+        header.fftOrder = (uint8_t) fftOrder;
+        header.numTraces = (uint8_t) numTraces;
+        header.recordType = SpectrumFile::FrameRecord;
+
+        if( halfFloat )
+        {
+            auto* out = reinterpret_cast<uint16_t*>(slot.payload.get());
+
+            for( int trace = 0; trace < numTraces; ++trace )
+                for( int bin = 0; bin < numBins; ++bin )
+                    *out++ = SpectrumFile::floatToHalf(traces[trace][bin]);
+        }
+        else
+        {
+            auto* out = slot.payload.get();
+            auto floor = fileHeader.floorDecibels;
+            auto scale = 255.f / (fileHeader.ceilingDecibels - floor);
+
+            for( int trace = 0; trace < numTraces; ++trace )
+                for( int bin = 0; bin < numBins; ++bin )
+                    *out++ = (uint8_t) juce::jlimit(0, 255, juce::roundToInt((traces[trace][bin] - floor) * scale));
+        }
+
+        std::memset(slot.payload.get() + payloadSize, 0, paddedSize - payloadSize);
+    }
+
+    dataReady.signal();
+}
+
+void SpectrumRecorder::run()
+{
+    while( ! threadShouldExit() )
+    {
+        dataReady.wait(100);
+        writeAvailableFrames();
+    }
+
+    writeAvailableFrames();
+    stream->flush();
+}
+
+void SpectrumRecorder::writeAvailableFrames()
+{
+    auto numReady = ringFifo.getNumReady();
+
+    for( int i = 0; i < numReady; ++i )
+    {
+        auto read = ringFifo.read(1);
+        auto& slot = slots[(size_t) read.startIndex1];
+
+        stream->write(&slot.header, sizeof(slot.header));
+        stream->write(slot.payload.get(), slot.header.recordSize - sizeof(slot.header));
+    }
+
+    if( numReady > 0 )
+        stream->flush();
+}
+
+//============================================================================== READER //==============================================================================
+
+bool SpectrumRecording::open(const juce::File& file)
+{
+    frames.clear();
+    sessionStarts.clear();
+    mappedFile = std::make_unique<juce::MemoryMappedFile>(file, juce::MemoryMappedFile::readOnly);
+
+    auto size = mappedFile->getSize();
+    if( mappedFile->getData() == nullptr || size < sizeof(fileHeader) )
+    {
+        mappedFile.reset();
+        return false;
+    }
+
+    std::memcpy(&fileHeader, getData(), sizeof(fileHeader));
+
+    if( std::memcmp(fileHeader.magic, SpectrumFile::magic, sizeof(fileHeader.magic)) != 0
+        || fileHeader.version > SpectrumFile::currentVersion )
+    {
+        mappedFile.reset();
+        return false;
+    }
+
+    auto bytesPerValue = (uint64_t) (fileHeader.encoding == SpectrumFile::HalfFloat ? sizeof(uint16_t) : sizeof(uint8_t));
+
+    // One pass to index the records. A torn last record, or a frame whose payload doesn't
+    // fit its record, ends the recording there.
+    auto offset = sizeof(fileHeader);
+    while( offset + sizeof(SpectrumFile::FrameHeader) <= size )
+    {
+        SpectrumFile::FrameHeader header;
+        std::memcpy(&header, getData() + offset, sizeof(header));
+
+        if( header.recordSize < sizeof(header) || offset + header.recordSize > size )
+            break;
+
+        if( header.recordType == SpectrumFile::FrameRecord )
+        {
+            auto payloadSize = (uint64_t) header.numTraces * header.numBins * bytesPerValue;
+            if( sizeof(header) + payloadSize > header.recordSize )
+                break;
+
+            frames.push_back({ offset, juce::jmax(0, (int) sessionStarts.size() - 1) });
+        }
+        else if( header.recordType == SpectrumFile::SessionRecord )
+        {
+            SpectrumFile::SessionHeader session;
+            std::memcpy(&session, getData() + offset, sizeof(session));
+            sessionStarts.push_back(session.startTimeSeconds);
+        }
+
+        offset += header.recordSize;
+    }
+
+    return true;
+}
+
+SpectrumFile::FrameHeader SpectrumRecording::getFrameHeader(int frameIndex) const
+{
+    jassert( juce::isPositiveAndBelow(frameIndex, getNumFrames()) );
+
+    SpectrumFile::FrameHeader header;
+    std::memcpy(&header, getData() + frames[(size_t) frameIndex].offset, sizeof(header));
+    return header;
+}
+
+SpectrumRecording::FrameInfo SpectrumRecording::getFrameInfo(int frameIndex) const
+{
+    auto header = getFrameHeader(frameIndex);
+
+    auto session = frames[(size_t) frameIndex].session;
+
+    FrameInfo info;
+    info.timestampSeconds = header.timestampSeconds;
+    info.sessionStartSeconds = sessionStarts.empty() ? 0 : sessionStarts[(size_t) session];
+    info.session = session;
+    info.sampleRate = header.sampleRate;
+    info.fftOrder = header.fftOrder;
+    info.numTraces = header.numTraces;
+    info.numBins = (int) header.numBins;
+    return info;
+}
+
+void SpectrumRecording::readFrame(int frameIndex, int trace, float* decibels) const
+{
+    auto header = getFrameHeader(frameIndex);
+    jassert( juce::isPositiveAndBelow(trace, (int) header.numTraces) );
+
+    auto numBins = (size_t) header.numBins;
+    auto* payload = getData() + frames[(size_t) frameIndex].offset + sizeof(header);
+
+    if( fileHeader.encoding == SpectrumFile::HalfFloat )
+    {
+        auto* in = payload + (size_t) trace * numBins * sizeof(uint16_t);
+
+        for( size_t bin = 0; bin < numBins; ++bin )
+        {
+            uint16_t half;
+            std::memcpy(&half, in + bin * sizeof(uint16_t), sizeof(half));
+            decibels[bin] = SpectrumFile::halfToFloat(half);
+        }
+    }
+    else
+    {
+        auto* in = payload + (size_t) trace * numBins;
+        auto floor = fileHeader.floorDecibels;
+        auto step = (fileHeader.ceilingDecibels - floor) / 255.f;
+
+        for( size_t bin = 0; bin < numBins; ++bin )
+            decibels[bin] = floor + step * (float) in[bin];
+    }
+}
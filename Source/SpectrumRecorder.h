@@ -0,0 +1,193 @@
+/*
+  ==============================================================================
+
+    SpectrumRecorder.h
+
+    Streams analyzer spectrum frames to disk for offline QA, and reads them back.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <cstdint>
+
+//==============================================================================
+/*
+ File layout, version 2. Everything is little-endian, in the native layout of the
+ x86-64 and arm64 targets the plugin is built for.
+
+    FileHeader                      32 bytes, once
+    { record header, payload }      repeated, each record padded to 8 bytes
+
+ Every record header is 24 bytes, starts with the record's size and ends with its
+ type. Each start() writes a SessionHeader with the wall clock time, the frames that
+ follow it are timed from there, so a file that was appended to keeps one clock.
+
+ The payload of a frame is numTraces * numBins values, trace after trace, either as
+ IEEE half floats (dB) or as 8-bit codes spread linearly over floor..ceiling dB.
+ Records are only ever appended, and every record carries its size and type, so a
+ reader skips record types it doesn't know and stops cleanly at a torn last record.
+
+ Version 1 had no session records and 0 where the type is now, which reads as frames.
+ */
+namespace SpectrumFile
+{
+    enum Encoding : uint16_t
+    {
+        HalfFloat = 0,
+        QuantizedDecibels8 = 1
+    };
+
+    enum RecordType : uint16_t
+    {
+        FrameRecord = 0,
+        SessionRecord = 1
+    };
+
+    constexpr uint16_t currentVersion = 2;
+    constexpr char magic[8] = { 'L', 'E', 'Q', 'S', 'P', 'E', 'C', 0 };
+
+    struct FileHeader
+    {
+        char magic[8];
+        uint16_t version;
+        uint16_t encoding;
+        float floorDecibels;
+        float ceilingDecibels;
+        uint32_t reserved[3];
+    };
+
+    struct FrameHeader
+    {
+        uint32_t recordSize;        // header + payload + padding
+        uint32_t numBins;
+        double timestampSeconds;    // since the session's start
+        float sampleRate;
+        uint8_t fftOrder;
+        uint8_t numTraces;
+        uint16_t recordType;        // FrameRecord
+    };
+
+    struct SessionHeader
+    {
+        uint32_t recordSize;
+        uint32_t reserved;
+        double startTimeSeconds;    // wall clock, since 1970 (UTC)
+        uint8_t reserved2[6];
+        uint16_t recordType;        // SessionRecord
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "FileHeader is part of the file format");
+    static_assert(sizeof(FrameHeader) == 24, "FrameHeader is part of the file format");
+    static_assert(sizeof(SessionHeader) == 24, "SessionHeader is part of the file format");
+
+    uint16_t floatToHalf(float value) noexcept;
+    float halfToFloat(uint16_t half) noexcept;
+}
+
+//============================================================================== WRITER //==============================================================================
+/*
+ Records frames pushed from the GUI thread on a background thread.
+
+ pushFrame encodes into a bounded ring of preallocated slots and returns straight
+ away, the writer thread drains the ring to the file. When the disk can't keep up the
+ ring fills and new frames are dropped and counted, so recording never stalls the GUI,
+ and the audio thread isn't involved at all.
+ */
+class SpectrumRecorder : private juce::Thread
+{
+public:
+    SpectrumRecorder();
+    ~SpectrumRecorder() override;
+
+    // Appends a new session to 'file' if it is a recording with the same encoding, otherwise
+    // starts it. Returns false if the file can't be opened or holds something else.
+    bool start(const juce::File& file,
+               SpectrumFile::Encoding encoding = SpectrumFile::HalfFloat,
+               float floorDecibels = -48.f,
+               float ceilingDecibels = 0.f);
+    void stop();
+
+    bool isRecording() const { return recording.get(); }
+    int getNumDroppedFrames() const { return droppedFrames.get(); }
+
+    // One dB spectrum frame, 'traces' holds numTraces pointers to numBins values.
+    // Call from one thread only (the GUI thread), never blocks.
+    void pushFrame(const float* const* traces, int numTraces, int numBins, double sampleRate, int fftOrder);
+
+    static constexpr int maxBins = 8192;
+    static constexpr int maxTraces = 2;
+
+private:
+    void run() override;
+    void writeAvailableFrames();
+
+    static constexpr int ringCapacity = 32;
+
+    struct Slot
+    {
+        SpectrumFile::FrameHeader header;
+        juce::HeapBlock<uint8_t> payload;
+    };
+
+    std::array<Slot, ringCapacity> slots;
+    juce::AbstractFifo ringFifo { ringCapacity };
+    juce::WaitableEvent dataReady;
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    SpectrumFile::FileHeader fileHeader;
+    double startTimeMs = 0;
+
+    juce::Atomic<bool> recording { false };
+    juce::Atomic<int> droppedFrames { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumRecorder)
+};
+
+//============================================================================== READER //==============================================================================
+/*
+ Memory-maps a recording and indexes its frames once on open, after that any frame
+ can be decoded in any order without touching the rest of the file.
+ */
+class SpectrumRecording
+{
+public:
+    struct FrameInfo
+    {
+        double timestampSeconds = 0;        // since its session's start
+        double sessionStartSeconds = 0;     // wall clock, since 1970 (UTC), 0 in version 1 files
+        int session = 0;                    // counts the sessions appended to the file
+        double sampleRate = 0;
+        int fftOrder = 0;
+        int numTraces = 0;
+        int numBins = 0;
+    };
+
+    bool open(const juce::File& file);
+
+    int getNumFrames() const { return (int) frames.size(); }
+    int getNumSessions() const { return juce::jmax(1, (int) sessionStarts.size()); }
+    FrameInfo getFrameInfo(int frameIndex) const;
+
+    // decodes one trace of one frame into 'decibels', which needs room for numBins values
+    void readFrame(int frameIndex, int trace, float* decibels) const;
+
+private:
+    const uint8_t* getData() const { return static_cast<const uint8_t*>(mappedFile->getData()); }
+    SpectrumFile::FrameHeader getFrameHeader(int frameIndex) const;
+
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    SpectrumFile::FileHeader fileHeader;
+
+    struct IndexEntry
+    {
+        size_t offset;
+        int session;
+    };
+
+    std::vector<IndexEntry> frames;
+    std::vector<double> sessionStarts;
+};
@@ -0,0 +1,311 @@
+/*
+  ==============================================================================
+
+    Tracing.cpp
+
+  ==============================================================================
+*/
+
+#include "Tracing.h"
+
+#if ! LAUTEQ_TRACING
+
+bool Tracing::start(const juce::File&) { return false; }
+void Tracing::stop() {}
+bool Tracing::isRunning() { return false; }
+
+#else
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+
+namespace Tracing
+{
+
+std::atomic<Session*> currentSession { nullptr };
+
+//==============================================================================
+// One thread's events, written by that thread and read by the session's writer thread.
+struct Ring
+{
+    static constexpr uint32_t capacity = 4096;      // a power of two, far more than a thread records between two drains
+
+    struct Event
+    {
+        const char* name;
+        juce::int64 startTicks, endTicks;
+    };
+
+    void push(const char* name, juce::int64 startTicks, juce::int64 endTicks) noexcept
+    {
+        auto write = writePosition.load(std::memory_order_relaxed);
+
+        if( write - readPosition.load(std::memory_order_acquire) == capacity )
+        {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        events[write & (capacity - 1)] = { name, startTicks, endTicks };
+        writePosition.store(write + 1, std::memory_order_release);
+    }
+
+    template<typename Function>
+    void popAll(Function&& function)
+    {
+        auto read = readPosition.load(std::memory_order_relaxed);
+        auto write = writePosition.load(std::memory_order_acquire);
+
+        for( ; read != write; ++read )
+            function(events[read & (capacity - 1)]);
+
+        readPosition.store(read, std::memory_order_release);
+    }
+
+    std::atomic<juce::Thread::ThreadID> threadId { nullptr };
+    char threadName[64] {};
+
+    std::array<Event, capacity> events;
+
+    // the two ends on their own cache lines, so writer and reader don't share one
+    alignas(64) std::atomic<uint32_t> writePosition { 0 };
+    alignas(64) std::atomic<uint32_t> readPosition { 0 };
+    std::atomic<uint32_t> droppedEvents { 0 };
+};
+
+//==============================================================================
+/*
+ A running trace: the rings, allocated up front, and the thread that drains them.
+
+ The file is Chrome's JSON array format, one event per line. A trace that was never
+ finished is still readable, the closing bracket is optional in that format.
+ */
+struct Session : private juce::Thread
+{
+    static constexpr int maxThreads = 16;
+
+    explicit Session(std::unique_ptr<juce::FileOutputStream> streamToUse) :
+    juce::Thread("Trace Writer"),
+    stream(std::move(streamToUse)),
+    originTicks(juce::Time::getHighResolutionTicks()),
+    microsecondsPerTick(1.0e6 / (double) juce::Time::getHighResolutionTicksPerSecond())
+    {
+        writeLine("[\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"LAUT EQ\"}}");
+        startThread();
+    }
+
+    // a trace that is still running when the process goes gets its end written as well
+    ~Session() override
+    {
+        if( ! finished )
+        {
+            auto* self = this;
+            currentSession.compare_exchange_strong(self, nullptr);
+            finish();
+        }
+    }
+
+    // This thread's ring, claimed on its first event. Null once all of them are taken.
+    Ring* getRing() noexcept
+    {
+        auto id = juce::Thread::getCurrentThreadId();
+        auto numClaimed = juce::jmin(numRingsClaimed.load(std::memory_order_acquire), maxThreads);
+
+        for( int i = 0; i < numClaimed; ++i )
+            if( rings[(size_t) i].threadId.load(std::memory_order_acquire) == id )
+                return &rings[(size_t) i];
+
+        if( numClaimed == maxThreads )
+        {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto index = numRingsClaimed.fetch_add(1);
+        if( index >= maxThreads )
+        {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        auto& ring = rings[(size_t) index];
+        nameRing(ring, index);
+        ring.threadId.store(id, std::memory_order_release);
+        return &ring;
+    }
+
+    // stops the writer thread, then writes the rest, the thread names and the drop count
+    void finish()
+    {
+        finished = true;
+        stopThread(4000);
+        writeAvailableEvents();
+
+        uint32_t numDropped = droppedEvents.load();
+        char line[160];
+
+        for( int i = 0; i < getNumClaimedRings(); ++i )
+        {
+            auto& ring = rings[(size_t) i];
+            numDropped += ring.droppedEvents.load();
+
+            if( ring.threadId.load(std::memory_order_acquire) == nullptr )
+                continue;
+
+            std::snprintf(line, sizeof(line),
+                          ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                          i, ring.threadName);
+            writeLine(line);
+        }
+
+        // full rings and threads beyond maxThreads, as a counter at the end of the timeline
+        if( numDropped > 0 )
+        {
+            std::snprintf(line, sizeof(line),
+                          ",\n{\"name\":\"dropped events\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"count\":%u}}",
+                          toMicroseconds(juce::Time::getHighResolutionTicks()), numDropped);
+            writeLine(line);
+        }
+
+        writeLine("\n]\n");
+        stream->flush();
+    }
+
+private:
+    void run() override
+    {
+        while( ! threadShouldExit() )
+        {
+            wait(50);
+            writeAvailableEvents();
+        }
+    }
+
+    void writeAvailableEvents()
+    {
+        char line[160];
+
+        for( int i = 0; i < getNumClaimedRings(); ++i )
+        {
+            rings[(size_t) i].popAll([&](const Ring::Event& event)
+            {
+                std::snprintf(line, sizeof(line),
+                              ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                              event.name, i, toMicroseconds(event.startTicks),
+                              (double) (event.endTicks - event.startTicks) * microsecondsPerTick);
+                writeLine(line);
+            });
+        }
+    }
+
+    // the name shows up as the thread's row in the viewer, quotes and backslashes won't
+    static void nameRing(Ring& ring, int index) noexcept
+    {
+        if( juce::MessageManager::existsAndIsCurrentThread() )
+        {
+            copyName(ring, "Message Thread");
+        }
+        else if( auto* thread = juce::Thread::getCurrentThread() )
+        {
+            // copied while the String is alive, its text goes with it
+            auto threadName = thread->getThreadName();
+            copyName(ring, threadName.toRawUTF8());
+        }
+        else
+        {
+            // the host's threads, the audio thread among them
+            char hostName[32];
+            std::snprintf(hostName, sizeof(hostName), "Host Thread %d", index);
+            copyName(ring, hostName);
+        }
+    }
+
+    static void copyName(Ring& ring, const char* name) noexcept
+    {
+        size_t i = 0;
+        for( ; name[i] != 0 && i < sizeof(ring.threadName) - 1; ++i )
+            ring.threadName[i] = (name[i] == '"' || name[i] == '\\' || (unsigned char) name[i] < 0x20) ? '_' : name[i];
+
+        ring.threadName[i] = 0;
+    }
+
+    int getNumClaimedRings() const { return juce::jmin(numRingsClaimed.load(std::memory_order_acquire), maxThreads); }
+
+    double toMicroseconds(juce::int64 ticks) const { return (double) (ticks - originTicks) * microsecondsPerTick; }
+
+    void writeLine(const char* text) { stream->write(text, std::strlen(text)); }
+
+    std::array<Ring, maxThreads> rings;
+    std::atomic<int> numRingsClaimed { 0 };
+    std::atomic<uint32_t> droppedEvents { 0 };
+
+    std::unique_ptr<juce::FileOutputStream> stream;
+    bool finished = false;
+    const juce::int64 originTicks;
+    const double microsecondsPerTick;
+};
+
+//==============================================================================
+namespace
+{
+    juce::CriticalSection sessionLock;
+
+    // A scope that began just before stop() may still end into its ring afterwards, so
+    // the finished session is only deleted once the next one is done as well.
+    std::unique_ptr<Session> runningSession, finishedSession;
+}
+
+bool start(const juce::File& file)
+{
+    const juce::ScopedLock sl(sessionLock);
+
+    if( runningSession != nullptr )
+        return false;
+
+    file.getParentDirectory().createDirectory();
+
+    // FileOutputStream opens existing files at their end
+    auto stream = std::make_unique<juce::FileOutputStream>(file);
+    if( stream->failedToOpen() )
+        return false;
+
+    stream->setPosition(0);
+    stream->truncate();
+
+    runningSession = std::make_unique<Session>(std::move(stream));
+    currentSession.store(runningSession.get(), std::memory_order_release);
+    return true;
+}
+
+void stop()
+{
+    const juce::ScopedLock sl(sessionLock);
+
+    if( runningSession == nullptr )
+        return;
+
+    currentSession.store(nullptr, std::memory_order_release);
+    runningSession->finish();
+    finishedSession = std::move(runningSession);
+}
+
+bool isRunning()
+{
+    return currentSession.load() != nullptr;
+}
+
+//==============================================================================
+Ring* Scope::getRing(Session* session) noexcept
+{
+    return session->getRing();
+}
+
+void Scope::record(Ring* ring, const char* name, juce::int64 startTicks) noexcept
+{
+    ring->push(name, startTicks, juce::Time::getHighResolutionTicks());
+}
+
+}
+
+#endif
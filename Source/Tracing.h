@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    Tracing.h
+
+    Scoped timing events from any thread, written as a Chrome trace (JSON) that
+    chrome://tracing and ui.perfetto.dev open as a timeline.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <atomic>
+
+// Off by default. Build with LAUTEQ_TRACING=1 to compile the trace points in, they are
+// still idle until start() is called, see Tracing::Scope for what that costs.
+#ifndef LAUTEQ_TRACING
+ #define LAUTEQ_TRACING 0
+#endif
+
+namespace Tracing
+{
+    constexpr bool isAvailable() { return LAUTEQ_TRACING != 0; }
+
+    // Traces every thread in the process into 'file', which is replaced. Returns false if
+    // tracing isn't compiled in, a trace is already running or the file can't be written.
+    bool start(const juce::File& file);
+
+    // Writes out what is still buffered and closes the file.
+    void stop();
+
+    bool isRunning();
+
+   #if LAUTEQ_TRACING
+    struct Session;
+    struct Ring;
+
+    // null while no trace is running
+    extern std::atomic<Session*> currentSession;
+
+    //==============================================================================
+    /*
+     Times its own lifetime as one event named 'name', which has to be a string literal
+     (it is stored as a pointer and written to the file as it is, without escaping).
+
+     While no trace is running that is an atomic load and a branch in the constructor,
+     and a null test and a branch in the destructor, all inline. The scope itself never
+     leaves the function, so the compiler keeps it in registers. Once running, an event
+     is two tick reads and a store into this thread's ring, nothing that locks or
+     allocates, so it is fine on the audio thread. A thread gets one of
+     Session::maxThreads rings the first time it records, threads beyond that, and
+     events that find their ring full, are counted and dropped.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(const char* nameToUse) noexcept : name(nameToUse)
+        {
+            if( auto* session = currentSession.load(std::memory_order_acquire) )
+            {
+                ring = getRing(session);
+                startTicks = juce::Time::getHighResolutionTicks();
+            }
+        }
+
+        ~Scope() noexcept
+        {
+            if( ring != nullptr )
+                record(ring, name, startTicks);
+        }
+
+    private:
+        // static, so 'this' isn't handed to a call the compiler can't see into
+        static Ring* getRing(Session* session) noexcept;
+        static void record(Ring* ring, const char* name, juce::int64 startTicks) noexcept;
+
+        Ring* ring = nullptr;
+        const char* name = nullptr;
+        juce::int64 startTicks = 0;
+
+        JUCE_DECLARE_NON_COPYABLE (Scope)
+    };
+   #endif
+}
+
+#if LAUTEQ_TRACING
+ #define LAUTEQ_TRACE_SCOPE(name) Tracing::Scope JUCE_JOIN_MACRO (traceScope, __LINE__) (name)
+#else
+ #define LAUTEQ_TRACE_SCOPE(name)
+#endif
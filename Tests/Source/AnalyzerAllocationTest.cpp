@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    AnalyzerAllocationTest.cpp
+
+    The analyzer draws its frames without touching the heap: a fixed sine goes
+    through the processor's tap, and once the buffers and paths have settled,
+    every frame of PathProducer and its path generators is counted. The test
+    target is built with LAUTEQ_COUNT_ALLOCATIONS=1.
+
+  ==============================================================================
+*/
+
+#include "../../Source/PluginEditor.h"
+
+struct AnalyzerAllocationTest : juce::UnitTest
+{
+    AnalyzerAllocationTest() : juce::UnitTest("Analyzer allocations", "LAUT EQ") {}
+
+    void runTest() override
+    {
+        beginTest("over-aligned new is counted");
+        {
+            struct alignas(128) Block { float samples[32]; };
+
+            auto before = AllocationCounter::getNumAllocations();
+            Block* volatile block = new Block();     // volatile, so the pair can't be elided
+            delete block;
+            Block* volatile blocks = new Block[4];
+            delete[] blocks;
+
+            expectEquals((juce::int64) (AllocationCounter::getNumAllocations() - before), (juce::int64) 2);
+        }
+
+        beginTest("no allocations per frame after warm-up");
+        {
+            constexpr double sampleRate = 48000.0;
+            constexpr int blockSize = LAUTEQAudioProcessor::analyzerBlockSize;
+            constexpr int numWarmUpFrames = 50, numFrames = 200;
+
+            LAUTEQAudioProcessor processor;
+            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+            processor.addAnalyzerSubscriber();
+
+            PathProducer producer(processor.leftChannelFifo, processor.rightChannelFifo);
+            const juce::Rectangle<float> bounds { 0.f, 0.f, 800.f, 300.f };
+
+            // 21 cycles per block, so every block and every spectrum is the same
+            juce::AudioBuffer<float> input(processor.getTotalNumInputChannels(), blockSize), buffer;
+            input.clear();
+            for( int channel = 0; channel < 2; ++channel )
+                for( int i = 0; i < blockSize; ++i )
+                    input.setSample(channel, i, 0.25f * std::sin(juce::MathConstants<float>::twoPi * 21.f * (float) i / (float) blockSize));
+
+            buffer.makeCopyOf(input);
+
+            juce::MidiBuffer midi;
+            std::array<juce::Path, 2> paths;
+
+            // the processor isn't counted, only what the editor's timer does with a frame
+            auto frame = [&]
+            {
+                buffer.makeCopyOf(input, true);
+                processor.processBlock(buffer, midi);
+
+                auto before = AllocationCounter::getNumAllocations();
+
+                producer.process(bounds, sampleRate);
+                for( int trace = 0; trace < producer.getNumPaths(); ++trace )
+                    producer.takePath(trace, paths[(size_t) trace]);
+
+                return AllocationCounter::getNumAllocations() - before;
+            };
+
+            for( int i = 0; i < numWarmUpFrames; ++i )
+                frame();
+
+            uint64_t allocations = 0;
+            for( int i = 0; i < numFrames; ++i )
+                allocations += frame();
+
+            expectEquals((juce::int64) allocations, (juce::int64) 0);
+            expect(! paths[0].isEmpty());
+
+            processor.removeAnalyzerSubscriber();
+        }
+    }
+};
+
+static AnalyzerAllocationTest analyzerAllocationTest;
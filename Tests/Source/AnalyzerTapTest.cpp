@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    AnalyzerTapTest.cpp
+
+  ==============================================================================
+*/
+
+#include "../../Source/PluginProcessor.h"
+
+struct AnalyzerTapTest : juce::UnitTest
+{
+    AnalyzerTapTest() : juce::UnitTest("Analyzer tap", "LAUT EQ") {}
+
+    void runTest() override
+    {
+        beginTest("a mono bus feeds both traces from channel 0");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = LAUTEQAudioProcessor::analyzerBlockSize;
+
+        LAUTEQAudioProcessor processor;
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(juce::AudioChannelSet::mono());
+        layout.inputBuses.add(juce::AudioChannelSet::disabled());
+        layout.outputBuses.add(juce::AudioChannelSet::mono());
+        expect(processor.setBusesLayout(layout));
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+        processor.addAnalyzerSubscriber();
+
+        // a sine on the mono channel, and silence in channel 1, which isn't part of the bus
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+
+        // a block is handed over when the next one starts, so two go in
+        for( int block = 0; block < 2; ++block )
+        {
+            buffer.clear();
+            for( int i = 0; i < blockSize; ++i )
+                buffer.setSample(0, i, 0.25f * std::sin(juce::MathConstants<float>::twoPi * 1000.f * (float) i / (float) sampleRate));
+
+            processor.processBlock(buffer, midi);
+        }
+
+        for( auto* fifo : { &processor.leftChannelFifo, &processor.rightChannelFifo } )
+        {
+            juce::AudioBuffer<float> tapped(1, blockSize);
+            expect(fifo->getAudioBuffer(tapped));
+            expectGreaterThan(tapped.getMagnitude(0, 0, blockSize), 0.05f);
+        }
+
+        processor.removeAnalyzerSubscriber();
+    }
+};
+
+static AnalyzerTapTest analyzerTapTest;
@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    Benchmark.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Average milliseconds per call of 'function', timed after a tenth as many warm-up calls
+template<typename Function>
+double measureMilliseconds(int numIterations, Function&& function)
+{
+    for( int i = 0; i < juce::jmax(1, numIterations / 10); ++i )
+        function();
+
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for( int i = 0; i < numIterations; ++i )
+        function();
+
+    auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    return 1000.0 * seconds / numIterations;
+}
@@ -0,0 +1,107 @@
+/*
+  ==============================================================================
+
+    BlockSizeBenchmark.cpp
+
+    processBlock on the same 8192 stereo samples, cut into host blocks of 1, 8, 32,
+    128 and 512 samples and into blocks of random size. The chain runs with the
+    dynamic peak band on, so the 32-sample control grid has work to do. With the
+    per-block work on that grid the cost per sample should stay close to the 512
+    sample figure down to small blocks.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+struct BlockSizeBenchmark : juce::UnitTest
+{
+    BlockSizeBenchmark() : juce::UnitTest("Host block sizes", "LAUT EQ Benchmarks") {}
+
+    static void setParameter(LAUTEQAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* param = processor.apvts.getParameter(parameterID);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    void runTest() override
+    {
+        beginTest("cost per sample by block size");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int maxBlockSize = 512, numSamples = 8192, numRuns = 200;
+
+        LAUTEQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate, maxBlockSize);
+        processor.prepareToPlay(sampleRate, maxBlockSize);
+
+        setParameter(processor, "Peak Gain", 6.f);
+        setParameter(processor, "Peak Dynamic", 1.f);
+        setParameter(processor, "Peak Threshold", -30.f);
+
+        // the same noise goes in every run, so the output can't run away
+        auto numChannels = processor.getTotalNumInputChannels();
+        juce::AudioBuffer<float> input(numChannels, numSamples), buffer;
+        juce::Random random(1);
+
+        for( int channel = 0; channel < numChannels; ++channel )
+            for( int i = 0; i < numSamples; ++i )
+                input.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+        buffer.makeCopyOf(input);
+
+        // the sizes every run cuts its samples into, one list per case
+        std::vector<std::vector<int>> cases;
+        juce::StringArray names;
+
+        for( auto blockSize : { 1, 8, 32, 128, 512 } )
+        {
+            cases.emplace_back((size_t) (numSamples / blockSize), blockSize);
+            names.add(juce::String::formatted("block %3d", blockSize));
+        }
+
+        std::vector<int> varying;
+        for( int total = 0; total < numSamples; )
+        {
+            auto blockSize = juce::jmin(1 + random.nextInt(maxBlockSize), numSamples - total);
+            varying.push_back(blockSize);
+            total += blockSize;
+        }
+
+        cases.push_back(varying);
+        names.add("varying  ");
+
+        juce::MidiBuffer midi;
+        std::vector<double> nsPerSample;
+
+        for( size_t c = 0; c < cases.size(); ++c )
+        {
+            auto& blockSizes = cases[c];
+
+            auto ms = measureMilliseconds(numRuns, [&]
+            {
+                buffer.makeCopyOf(input, true);
+
+                int start = 0;
+                for( auto blockSize : blockSizes )
+                {
+                    // a block of the host's size, pointing into the run's buffer
+                    juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), numChannels, start, blockSize);
+                    processor.processBlock(block, midi);
+                    start += blockSize;
+                }
+            });
+
+            nsPerSample.push_back(1.0e6 * ms / numSamples);
+        }
+
+        auto referenceNs = nsPerSample[cases.size() - 2];      // block 512
+
+        for( size_t c = 0; c < cases.size(); ++c )
+            logMessage(juce::String::formatted("%s: %6.1f ns per sample, %.2fx block 512",
+                                               names[(int) c].toRawUTF8(), nsPerSample[c], nsPerSample[c] / referenceNs));
+    }
+};
+
+static BlockSizeBenchmark blockSizeBenchmark;
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    DecibelBenchmark.cpp
+
+    The analyzer's per-frame conversion of N/2 bins to decibels, FFT orders 10 to
+    14: SIMDKernels::gainToDecibels against the two loops it replaced, the
+    isinf/isnan normalise loop followed by a juce::Decibels::gainToDecibels loop.
+    Both restore the same magnitudes before every run, so the copy is in both.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/SIMDKernels.h"
+
+struct DecibelBenchmark : juce::UnitTest
+{
+    DecibelBenchmark() : juce::UnitTest("Analyzer decibel conversion", "LAUT EQ Benchmarks") {}
+
+    static constexpr float negativeInfinity = -48.f;
+
+    // what produceFFTDataForRendering used to do
+    static void twoLoops(float* data, int numBins)
+    {
+        for( int i = 0; i < numBins; ++i )
+        {
+            auto v = data[i];
+            if( !std::isinf(v) && !std::isnan(v) )
+            {
+                v /= float(numBins);
+            }
+            else
+            {
+                v = 0.f;
+            }
+            data[i] = v;
+        }
+
+        for( int i = 0; i < numBins; ++i )
+        {
+            data[i] = juce::Decibels::gainToDecibels(data[i], negativeInfinity);
+        }
+    }
+
+    void runTest() override
+    {
+        beginTest("by FFT order");
+
+        constexpr int numRuns = 20000;
+        juce::Random random(1);
+
+        for( int order = 10; order <= 14; ++order )
+        {
+            auto numBins = (1 << order) / 2;
+
+            // magnitudes as a frame of noise gives them, a few of them silent
+            std::vector<float> magnitudes((size_t) numBins), data((size_t) numBins);
+            for( auto& magnitude : magnitudes )
+                magnitude = random.nextInt(50) == 0 ? 0.f : random.nextFloat() * (float) numBins;
+
+            auto oldMs = measureMilliseconds(numRuns, [&]
+            {
+                std::copy(magnitudes.begin(), magnitudes.end(), data.begin());
+                twoLoops(data.data(), numBins);
+            });
+
+            auto expected = data;
+
+            auto fusedMs = measureMilliseconds(numRuns, [&]
+            {
+                std::copy(magnitudes.begin(), magnitudes.end(), data.begin());
+                SIMDKernels::gainToDecibels(data.data(), numBins, 1.f / float(numBins), negativeInfinity);
+            });
+
+            auto maxDeviation = 0.f;
+            for( size_t i = 0; i < data.size(); ++i )
+                maxDeviation = juce::jmax(maxDeviation, std::abs(data[i] - expected[i]));
+
+            // the polynomial log2 is good to about 6e-4 dB
+            expectLessThan(maxDeviation, 1.0e-3f);
+
+            logMessage(juce::String::formatted("order %d (%4d bins): %6.1f us -> %5.1f us, %.1fx, max deviation %.5f dB",
+                                               order, numBins, 1000.0 * oldMs, 1000.0 * fusedMs, oldMs / fusedMs, maxDeviation));
+        }
+    }
+};
+
+static DecibelBenchmark decibelBenchmark;
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    DynamicBenchmark.cpp
+
+    processBlock on 512 sample stereo blocks with "Peak Dynamic" off, on with the
+    detector on the dry input, and on with the detector on the sidechain bus. The
+    sidechain bus is enabled in all three, so only the dynamic band makes the
+    difference.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+struct DynamicBenchmark : juce::UnitTest
+{
+    DynamicBenchmark() : juce::UnitTest("Dynamic peak band", "LAUT EQ Benchmarks") {}
+
+    static void setParameter(LAUTEQAudioProcessor& processor, const char* parameterID, float value)
+    {
+        auto* param = processor.apvts.getParameter(parameterID);
+        param->setValueNotifyingHost(param->convertTo0to1(value));
+    }
+
+    void runTest() override
+    {
+        beginTest("static, internal detector, sidechain");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512, numBlocks = 2000;
+
+        LAUTEQAudioProcessor processor;
+
+        juce::AudioProcessor::BusesLayout layout;
+        layout.inputBuses.add(juce::AudioChannelSet::stereo());
+        layout.inputBuses.add(juce::AudioChannelSet::stereo());
+        layout.outputBuses.add(juce::AudioChannelSet::stereo());
+        expect(processor.setBusesLayout(layout));
+
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        setParameter(processor, "Peak Gain", 6.f);
+        setParameter(processor, "Peak Threshold", -30.f);
+
+        // main bus in channels 0 and 1, sidechain in 2 and 3, the same noise every block
+        juce::AudioBuffer<float> input(processor.getTotalNumInputChannels(), blockSize), buffer;
+        juce::Random random(1);
+
+        for( int channel = 0; channel < input.getNumChannels(); ++channel )
+            for( int i = 0; i < blockSize; ++i )
+                input.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+        buffer.makeCopyOf(input);
+
+        struct Case { const char* name; bool dynamic, sidechain; };
+        juce::MidiBuffer midi;
+        double staticMs = 0;
+
+        for( auto& c : { Case { "static   ", false, false },
+                         Case { "internal ", true, false },
+                         Case { "sidechain", true, true } } )
+        {
+            setParameter(processor, "Peak Dynamic", c.dynamic ? 1.f : 0.f);
+            setParameter(processor, "Peak Sidechain", c.sidechain ? 1.f : 0.f);
+
+            auto ms = measureMilliseconds(numBlocks, [&]
+            {
+                buffer.makeCopyOf(input, true);
+                processor.processBlock(buffer, midi);
+            });
+
+            if( ! c.dynamic )
+                staticMs = ms;
+
+            logMessage(juce::String::formatted("%s: %.2f us per block, %.2fx static",
+                                               c.name, 1000.0 * ms, ms / staticMs));
+        }
+    }
+};
+
+static DynamicBenchmark dynamicBenchmark;
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    EngineBenchmark.cpp
+
+    EQEngine on 512-sample stereo blocks at 48 kHz with 0 to 24 active peak bands.
+    The cost should grow by the same amount for every band, the last column is what
+    each band adds, per sample and channel, over the block with no bands at all.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/EQEngine.h"
+
+struct EngineBenchmark : juce::UnitTest
+{
+    EngineBenchmark() : juce::UnitTest("Band engine", "LAUT EQ Benchmarks") {}
+
+    static constexpr int numChannels = 2, blockSize = 512, numBlocks = 20000;
+
+    void runTest() override
+    {
+        juce::AudioBuffer<float> input(numChannels, blockSize), buffer(numChannels, blockSize);
+
+        juce::Random random(1);
+        for( int channel = 0; channel < numChannels; ++channel )
+            for( int i = 0; i < blockSize; ++i )
+                input.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+        beginTest("cost by number of active bands");
+        {
+            double emptyMs = 0;
+
+            for( int numBands = 0; numBands <= EQDesign::maxBands; ++numBands )
+            {
+                // peaks spread over the range, alternately boosting and cutting
+                EQEngine engine;
+                for( int band = 0; band < numBands; ++band )
+                {
+                    BandSettings peak;
+                    peak.frequency = 40.f * std::pow(2.f, (float) band * 0.375f);
+                    peak.gainInDecibels = band % 2 == 0 ? 3.f : -3.f;
+                    peak.quality = 1.f;
+                    engine.setBand(band, peak, 48000.0);
+                }
+
+                // the input is restored every block, so the same signal goes through every time
+                auto ms = measureMilliseconds(numBlocks, [&]
+                {
+                    juce::ScopedNoDenormals noDenormals;
+                    buffer.makeCopyOf(input, true);
+                    engine.process(buffer.getArrayOfWritePointers(), numChannels, blockSize);
+                });
+
+                if( numBands == 0 )
+                {
+                    emptyMs = ms;
+                    logMessage(juce::String::formatted(" 0 bands: %5.2f us per block", 1000.0 * ms));
+                    continue;
+                }
+
+                auto nsPerBand = 1.0e6 * (ms - emptyMs) / (numBands * blockSize * numChannels);
+                logMessage(juce::String::formatted("%2d bands: %5.2f us per block, %.2f ns per sample, band and channel",
+                                                   numBands, 1000.0 * ms, nsPerBand));
+            }
+        }
+    }
+};
+
+static EngineBenchmark engineBenchmark;
@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    FifoTest.cpp
+
+  ==============================================================================
+*/
+
+#include "../../Source/PluginProcessor.h"
+
+struct FifoTest : juce::UnitTest
+{
+    FifoTest() : juce::UnitTest("Fifo", "LAUT EQ") {}
+
+    void runTest() override
+    {
+        beginTest("a fifo holds Capacity items");
+        {
+            Fifo<std::vector<float>, 3> fifo;
+            fifo.prepare(16);
+
+            std::vector<float> item(16, 1.f);
+            for( int i = 0; i < 3; ++i )
+                expect(fifo.push(item));
+
+            expect(! fifo.push(item));
+            expectEquals(fifo.getNumAvailableForReading(), 3);
+        }
+
+        beginTest("the analyzer fifos follow the sample rate");
+        {
+            expectEquals(LAUTEQAudioProcessor::getNumAnalyzerFifoBlocks(44100.0), 7);
+            expectEquals(LAUTEQAudioProcessor::getNumAnalyzerFifoBlocks(48000.0), 8);
+            expectEquals(LAUTEQAudioProcessor::getNumAnalyzerFifoBlocks(192000.0), 29);
+
+            constexpr double sampleRate = 96000.0;
+            constexpr int blockSize = LAUTEQAudioProcessor::analyzerBlockSize;
+            auto numBlocks = LAUTEQAudioProcessor::getNumAnalyzerFifoBlocks(sampleRate);
+
+            LAUTEQAudioProcessor processor;
+            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+            processor.addAnalyzerSubscriber();
+
+            expectEquals(processor.leftChannelFifo.getNumBlocks(), numBlocks);
+
+            // nobody reads, so the fifo fills up to what it holds and stays there
+            juce::AudioBuffer<float> buffer(processor.getTotalNumInputChannels(), blockSize);
+            juce::MidiBuffer midi;
+
+            for( int block = 0; block < numBlocks + 5; ++block )
+            {
+                buffer.clear();
+                processor.processBlock(buffer, midi);
+            }
+
+            expectEquals(processor.leftChannelFifo.getNumCompleteBuffersAvailable(), numBlocks);
+            expectEquals(processor.rightChannelFifo.getNumCompleteBuffersAvailable(), numBlocks);
+
+            processor.removeAnalyzerSubscriber();
+        }
+    }
+};
+
+static FifoTest fifoTest;
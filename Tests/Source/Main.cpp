@@ -0,0 +1,31 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Runs the unit tests and returns non-zero if any of them failed. With --bench
+    it runs the benchmarks instead, which only log what they measured.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+int main(int argc, char* argv[])
+{
+    // a message manager for the processor's timers, fonts for the paint benchmark
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::ArgumentList arguments(argc, argv);
+    auto category = arguments.containsOption("--bench") ? "LAUT EQ Benchmarks" : "LAUT EQ";
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTestsInCategory(category);
+
+    int numFailures = 0;
+    for( int i = 0; i < runner.getNumResults(); ++i )
+        numFailures += runner.getResult(i)->failures;
+
+    return numFailures > 0 ? 1 : 0;
+}
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    MidiBenchmark.cpp
+
+    processBlock with 0, 10 and 100 mapped controller events per 512 sample
+    block. Every event splits the block and moves the peak gain, so this is the
+    price of sample accurate automation.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+struct MidiBenchmark : juce::UnitTest
+{
+    MidiBenchmark() : juce::UnitTest("MIDI controller events", "LAUT EQ Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("events per block");
+
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 512, numBlocks = 2000, controller = 7, peakGainIndex = 3;
+
+        LAUTEQAudioProcessor processor;
+        processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        // the same noise goes in every block, so the output can't run away
+        juce::AudioBuffer<float> input(processor.getTotalNumInputChannels(), blockSize), buffer;
+        juce::Random random(1);
+
+        for( int channel = 0; channel < input.getNumChannels(); ++channel )
+            for( int i = 0; i < blockSize; ++i )
+                input.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+
+        buffer.makeCopyOf(input);
+
+        // binds the controller to the peak gain
+        juce::MidiBuffer midi;
+        processor.learnMidiController(peakGainIndex);
+        midi.addEvent(juce::MidiMessage::controllerEvent(1, controller, 64), 0);
+        processor.processBlock(buffer, midi);
+
+        double zeroEventsMs = 0;
+
+        for( auto numEvents : { 0, 10, 100 } )
+        {
+            midi.clear();
+            for( int i = 0; i < numEvents; ++i )
+                midi.addEvent(juce::MidiMessage::controllerEvent(1, controller, (i * 13) % 128), i * blockSize / numEvents);
+
+            auto ms = measureMilliseconds(numBlocks, [&]
+            {
+                buffer.makeCopyOf(input, true);
+                auto events = midi;     // the host hands a fresh buffer every block
+                processor.processBlock(buffer, events);
+            });
+
+            if( numEvents == 0 )
+                zeroEventsMs = ms;
+
+            logMessage(juce::String::formatted("%3d events: %.2f us per block, %.2fx the block without events",
+                                               numEvents, 1000.0 * ms, ms / zeroEventsMs));
+        }
+    }
+};
+
+static MidiBenchmark midiBenchmark;
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    PaintBenchmark.cpp
+
+    The spectrum part of a repaint, drawn the way the analyzer did before it had
+    a layer cache (every trace copied and stroked on every paint) and the way it
+    does now (the layer stroked once per analyzer frame, blitted on every paint).
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginEditor.h"
+
+struct PaintBenchmark : juce::UnitTest
+{
+    PaintBenchmark() : juce::UnitTest("Spectrum paint", "LAUT EQ Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("paint cost before and after the spectrum layer");
+
+        constexpr int fftSize = 8192;
+        constexpr float negativeInfinity = -48.f;
+        const juce::Rectangle<int> area { 0, 0, 800, 300 };
+
+        // paths of a pink-ish spectrum with noise on it, the same ones every run
+        juce::Random random(42);
+        std::vector<float> spectrum((size_t) fftSize / 2);
+        std::array<std::array<juce::Path, 2>, maxSpectrumTrails> trails;
+        AnalyzerPathGenerator<juce::Path> generator;
+
+        for( auto& frame : trails )
+        {
+            for( auto& path : frame )
+            {
+                for( size_t k = 0; k < spectrum.size(); ++k )
+                    spectrum[k] = -3.f * std::log2(1.f + (float) k) + 6.f * random.nextFloat();
+
+                generator.generatePath(spectrum, area.toFloat(), fftSize, 48000.f / fftSize, negativeInfinity);
+                generator.getPath(path);
+            }
+        }
+
+        const SpectrumLayerSettings settings;
+        const auto transform = juce::AffineTransform::translation(1.f, 0);
+
+        for( auto scale : { 1.f, 2.f } )
+        {
+            juce::Image target(juce::Image::ARGB, juce::roundToInt(area.getWidth() * scale),
+                               juce::roundToInt(area.getHeight() * scale), true);
+            juce::Graphics g(target);
+            g.addTransform(juce::AffineTransform::scale(scale));
+
+            // before: five rounds of both traces, each path copied and moved first
+            auto before = measureMilliseconds(200, [&]
+            {
+                for( int y = 0; y < 5; ++y )
+                {
+                    for( auto& path : trails[0] )
+                    {
+                        auto copy = path;
+                        copy.applyTransform(transform);
+                        g.setColour(juce::Colours::blue);
+                        g.strokePath(copy, juce::PathStrokeType(1.f));
+                    }
+                }
+            });
+
+            // now: a new analyzer frame strokes the trails into the layer once ...
+            LayerCache layer;
+            layer.prepare(area, scale);
+
+            auto render = measureMilliseconds(200, [&]
+            {
+                layer.render([&](juce::Graphics& lg)
+                {
+                    for( int trail = settings.numTrails - 1; trail >= 0; --trail )
+                    {
+                        lg.setColour(juce::Colours::blue.withMultipliedAlpha(1.f - float(trail) / float(settings.numTrails)));
+
+                        for( auto& path : trails[(size_t) trail] )
+                            lg.strokePath(path, juce::PathStrokeType(settings.strokeWidth), transform);
+                    }
+                });
+            });
+
+            // ... and every paint only blits it
+            auto blit = measureMilliseconds(200, [&] { layer.draw(g, area); });
+
+            logMessage(juce::String::formatted("%dx%d at scale %.0f: before %.3f ms per paint, "
+                                               "now %.3f ms per paint plus %.3f ms per analyzer frame (%d trails)",
+                                               area.getWidth(), area.getHeight(), scale,
+                                               before, blit, render, settings.numTrails));
+        }
+    }
+};
+
+static PaintBenchmark paintBenchmark;
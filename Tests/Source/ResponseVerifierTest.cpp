@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    ResponseVerifierTest.cpp
+
+    The CHECK button's verification, without the editor: the audio path has to
+    follow the analytic curve within the default tolerance.
+
+  ==============================================================================
+*/
+
+#include "../../Source/ResponseVerifier.h"
+
+struct ResponseVerifierTest : juce::UnitTest
+{
+    ResponseVerifierTest() : juce::UnitTest("Response verifier", "LAUT EQ") {}
+
+    static void set(LAUTEQAudioProcessor& processor, const char* id, float value)
+    {
+        auto* parameter = processor.apvts.getParameter(id);
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+    }
+
+    void check(LAUTEQAudioProcessor& processor)
+    {
+        auto result = ResponseVerifier::run(processor);
+        logMessage(result.describe());
+
+        expectGreaterThan(result.numBinsChecked, 0);
+        expect(result.passed, result.describe());
+    }
+
+    void runTest() override
+    {
+        beginTest("flat");
+        {
+            LAUTEQAudioProcessor processor;
+            check(processor);
+        }
+
+        beginTest("cuts and a peak, linked stereo");
+        {
+            LAUTEQAudioProcessor processor;
+            set(processor, "LowCut Freq", 80.f);
+            set(processor, "LowCut Slope", 3.f);
+            set(processor, "HighCut Freq", 12000.f);
+            set(processor, "HighCut Slope", 1.f);
+            set(processor, "Peak Freq", 1000.f);
+            set(processor, "Peak Gain", 6.f);
+            set(processor, "Peak Quality", 2.f);
+            check(processor);
+        }
+
+        beginTest("mid/side with a different side");
+        {
+            LAUTEQAudioProcessor processor;
+            set(processor, "Mid Side", 1.f);
+            set(processor, "Peak Freq", 1000.f);
+            set(processor, "Peak Gain", 6.f);
+            set(processor, "Side Peak Freq", 3000.f);
+            set(processor, "Side Peak Gain", -9.f);
+            set(processor, "Side LowCut Freq", 150.f);
+            check(processor);
+        }
+    }
+};
+
+static ResponseVerifierTest responseVerifierTest;
@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    SpectrumRecorderTest.cpp
+
+  ==============================================================================
+*/
+
+#include "../../Source/SpectrumRecorder.h"
+
+struct SpectrumRecorderTest : juce::UnitTest
+{
+    SpectrumRecorderTest() : juce::UnitTest("Spectrum recorder", "LAUT EQ") {}
+
+    void runTest() override
+    {
+        juce::TemporaryFile temporaryFile(".lspec");
+        auto file = temporaryFile.getFile();
+
+        std::vector<float> left(512), right(512);
+        for( size_t k = 0; k < left.size(); ++k )
+        {
+            left[k] = -0.25f * (float) k;
+            right[k] = -0.5f * (float) k;
+        }
+        const float* traces[] { left.data(), right.data() };
+
+        beginTest("appending starts a new session");
+        {
+            SpectrumRecorder recorder;
+
+            for( int session = 0; session < 2; ++session )
+            {
+                expect(recorder.start(file));
+                recorder.pushFrame(traces, 2, (int) left.size(), 48000.0, 10);
+                recorder.stop();
+            }
+
+            SpectrumRecording recording;
+            expect(recording.open(file));
+            expectEquals(recording.getNumSessions(), 2);
+            expectEquals(recording.getNumFrames(), 2);
+
+            auto first = recording.getFrameInfo(0);
+            auto second = recording.getFrameInfo(1);
+            expectEquals(first.session, 0);
+            expectEquals(second.session, 1);
+            expect(first.sessionStartSeconds > 0);
+            expect(second.sessionStartSeconds >= first.sessionStartSeconds);
+            expectEquals(second.numBins, (int) left.size());
+
+            std::vector<float> decoded(left.size());
+            recording.readFrame(1, 1, decoded.data());
+            for( size_t k = 0; k < decoded.size(); ++k )
+                expectWithinAbsoluteError(decoded[k], right[k], 0.25f);
+        }
+
+        beginTest("a frame bigger than its record isn't indexed");
+        {
+            SpectrumFile::FileHeader fileHeader {};
+            std::memcpy(fileHeader.magic, SpectrumFile::magic, sizeof(fileHeader.magic));
+            fileHeader.version = SpectrumFile::currentVersion;
+            fileHeader.encoding = SpectrumFile::HalfFloat;
+
+            SpectrumFile::FrameHeader frame {};
+            frame.recordSize = sizeof(frame) + 8;
+            frame.numBins = 4096;
+            frame.numTraces = 2;
+            frame.recordType = SpectrumFile::FrameRecord;
+
+            const uint8_t payload[8] {};
+
+            file.deleteFile();
+            {
+                juce::FileOutputStream stream(file);
+                stream.write(&fileHeader, sizeof(fileHeader));
+                stream.write(&frame, sizeof(frame));
+                stream.write(payload, sizeof(payload));
+            }
+
+            SpectrumRecording recording;
+            expect(recording.open(file));
+            expectEquals(recording.getNumFrames(), 0);
+        }
+    }
+};
+
+static SpectrumRecorderTest spectrumRecorderTest;
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    StateBenchmark.cpp
+
+    Saving and restoring 1000 instances, the way a big session does on open and
+    save, with the binary blob against the ValueTree state it replaced.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/PluginProcessor.h"
+
+struct StateBenchmark : juce::UnitTest
+{
+    StateBenchmark() : juce::UnitTest("State save and load", "LAUT EQ Benchmarks") {}
+
+    void runTest() override
+    {
+        beginTest("1000 instances");
+
+        constexpr int numInstances = 1000;
+
+        juce::OwnedArray<LAUTEQAudioProcessor> instances;
+        for( int i = 0; i < numInstances; ++i )
+            instances.add(new LAUTEQAudioProcessor());
+
+        std::vector<juce::MemoryBlock> blobs((size_t) numInstances), trees((size_t) numInstances);
+
+        auto saveBlob = measureMilliseconds(5, [&]
+        {
+            for( int i = 0; i < numInstances; ++i )
+            {
+                blobs[(size_t) i].reset();
+                instances[i]->getStateInformation(blobs[(size_t) i]);
+            }
+        });
+
+        auto loadBlob = measureMilliseconds(5, [&]
+        {
+            for( int i = 0; i < numInstances; ++i )
+                instances[i]->setStateInformation(blobs[(size_t) i].getData(), (int) blobs[(size_t) i].getSize());
+        });
+
+        // what getStateInformation did before the blob
+        auto saveTree = measureMilliseconds(5, [&]
+        {
+            for( int i = 0; i < numInstances; ++i )
+            {
+                trees[(size_t) i].reset();
+                juce::MemoryOutputStream mos(trees[(size_t) i], true);
+                instances[i]->apvts.copyState().writeToStream(mos);
+            }
+        });
+
+        auto loadTree = measureMilliseconds(5, [&]
+        {
+            for( int i = 0; i < numInstances; ++i )
+                instances[i]->setStateInformation(trees[(size_t) i].getData(), (int) trees[(size_t) i].getSize());
+        });
+
+        logMessage(juce::String::formatted("blob: %.2f ms save, %.2f ms load, %d bytes each",
+                                           saveBlob, loadBlob, (int) blobs[0].getSize()));
+        logMessage(juce::String::formatted("ValueTree: %.2f ms save, %.2f ms load, %d bytes each",
+                                           saveTree, loadTree, (int) trees[0].getSize()));
+    }
+};
+
+static StateBenchmark stateBenchmark;
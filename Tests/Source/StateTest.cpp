@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    StateTest.cpp
+
+  ==============================================================================
+*/
+
+#include "../../Source/PluginProcessor.h"
+
+struct StateTest : juce::UnitTest
+{
+    StateTest() : juce::UnitTest("State", "LAUT EQ") {}
+
+    void runTest() override
+    {
+        constexpr int headerSize = 8, numControllers = 128;
+        constexpr int peakGainIndex = 3;
+        constexpr int numValues = LAUTEQAudioProcessor::numStateParameters;
+
+        beginTest("a blob from a newer version restores what this version knows");
+        {
+            LAUTEQAudioProcessor source;
+            juce::MemoryBlock current;
+            source.getStateInformation(current);
+            expectEquals((int) current.getSize(), headerSize + numValues * (int) sizeof(float) + numControllers);
+
+            juce::MemoryInputStream in(current, false);
+            auto magic = in.readInt();
+            in.readShort();
+            in.readShort();
+
+            // as a later version might write it: two more values, then the controller map,
+            // then something this version has never heard of
+            juce::MemoryBlock newer;
+            {
+                juce::MemoryOutputStream out(newer, false);
+                out.writeInt(magic);
+                out.writeShort(3);
+                out.writeShort((short) (numValues + 2));
+
+                for( int i = 0; i < numValues; ++i )
+                {
+                    auto value = in.readFloat();
+                    out.writeFloat(i == peakGainIndex ? 6.f : value);
+                }
+
+                out.writeFloat(1.f);
+                out.writeFloat(2.f);
+
+                for( int controller = 0; controller < numControllers; ++controller )
+                    out.writeByte((char) (controller == 7 ? peakGainIndex : -1));
+
+                for( int i = 0; i < 16; ++i )
+                    out.writeByte((char) 0x5a);
+            }
+
+            LAUTEQAudioProcessor destination;
+            destination.setStateInformation(newer.getData(), (int) newer.getSize());
+            expectEquals(destination.apvts.getRawParameterValue("Peak Gain")->load(), 6.f);
+
+            // saved again in this version's layout, the controller map came through
+            juce::MemoryBlock saved;
+            destination.getStateInformation(saved);
+            auto* bytes = static_cast<const int8_t*>(saved.getData());
+            auto controllersStart = headerSize + numValues * (int) sizeof(float);
+
+            expectEquals((int) bytes[controllersStart + 7], peakGainIndex);
+            expectEquals((int) bytes[controllersStart + 8], -1);
+        }
+
+        beginTest("a session saved with the generator running reopens with it off");
+        {
+            LAUTEQAudioProcessor source;
+            auto* type = source.apvts.getParameter("Generator");
+            auto* level = source.apvts.getParameter("Generator Level");
+            type->setValueNotifyingHost(type->convertTo0to1((float) GeneratorSweep));
+            level->setValueNotifyingHost(level->convertTo0to1(-6.f));
+
+            juce::MemoryBlock saved;
+            source.getStateInformation(saved);
+
+            LAUTEQAudioProcessor destination;
+            destination.setStateInformation(saved.getData(), (int) saved.getSize());
+            expectEquals((int) destination.apvts.getRawParameterValue("Generator")->load(), (int) GeneratorOff);
+            expectEquals(destination.apvts.getRawParameterValue("Generator Level")->load(), -6.f);
+        }
+    }
+};
+
+static StateTest stateTest;
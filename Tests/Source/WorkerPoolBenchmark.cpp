@@ -0,0 +1,132 @@
+/*
+  ==============================================================================
+
+    WorkerPoolBenchmark.cpp
+
+    Offline rendering of a 16 channel bus through the channel worker pool. First
+    one track with 0, 1, 3 and 7 workers, then 1 to 16 tracks rendering side by
+    side, all on the one shared pool against all of them doing their own pairs.
+    The numbers only mean something next to the core count, which is logged too.
+
+  ==============================================================================
+*/
+
+#include "Benchmark.h"
+#include "../../Source/ChannelWorkerPool.h"
+#include "../../Source/EQEngine.h"
+#include <thread>
+
+struct WorkerPoolBenchmark : juce::UnitTest
+{
+    WorkerPoolBenchmark() : juce::UnitTest("Channel worker pool", "LAUT EQ Benchmarks") {}
+
+    static constexpr int numChannels = EQEngine::maxChannels, blockSize = 512, numBlocks = 2000;
+
+    // an engine with a 3-band chain and its own 16 channels of noise
+    struct Track
+    {
+        Track()
+        {
+            BandSettings lowCut;
+            lowCut.type = LowCutBand;
+            lowCut.frequency = 40.f;
+            lowCut.order = 4;
+            engine.setBand(0, lowCut, 48000.0);
+
+            BandSettings peak;
+            peak.frequency = 1000.f;
+            peak.gainInDecibels = 4.f;
+            peak.quality = 1.f;
+            engine.setBand(1, peak, 48000.0);
+
+            BandSettings highCut;
+            highCut.type = HighCutBand;
+            highCut.frequency = 15000.f;
+            highCut.order = 2;
+            engine.setBand(2, highCut, 48000.0);
+
+            juce::Random random;
+            for( int channel = 0; channel < numChannels; ++channel )
+                for( int i = 0; i < blockSize; ++i )
+                    buffer.setSample(channel, i, random.nextFloat() * 0.5f - 0.25f);
+        }
+
+        void renderBlock(ChannelWorkerPool* pool)
+        {
+            auto* channels = buffer.getArrayOfWritePointers();
+            auto processPair = [&](int pair) { engine.processPair(pair, channels, numChannels, blockSize); };
+
+            if( pool == nullptr || ! pool->tryRun(EQEngine::getNumPairs(numChannels), processPair) )
+                engine.process(channels, numChannels, blockSize);
+        }
+
+        EQEngine engine;
+        juce::AudioBuffer<float> buffer { numChannels, blockSize };
+    };
+
+    // every track renders numBlocks blocks on a thread of its own, milliseconds for all of them
+    static double renderSideBySide(juce::OwnedArray<Track>& tracks, ChannelWorkerPool* pool)
+    {
+        std::vector<std::thread> threads;
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        for( auto* track : tracks )
+            threads.emplace_back([track, pool]
+            {
+                for( int block = 0; block < numBlocks; ++block )
+                    track->renderBlock(pool);
+            });
+
+        for( auto& thread : threads )
+            thread.join();
+
+        return 1000.0 * juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+
+    void runTest() override
+    {
+        logMessage(juce::String::formatted("%d cores, the shared pool would have %d workers",
+                                           juce::SystemStats::getNumCpus(), ChannelWorkerPool::getDefaultNumWorkers()));
+
+        beginTest("one track, by number of workers");
+        {
+            Track track;
+            double inlineMs = 0;
+
+            for( auto numWorkers : { 0, 1, 3, 7 } )
+            {
+                ChannelWorkerPool pool(numWorkers);
+                auto ms = measureMilliseconds(numBlocks, [&] { track.renderBlock(&pool); });
+
+                if( numWorkers == 0 )
+                    inlineMs = ms;
+
+                logMessage(juce::String::formatted("%d workers: %.2f us per block, %.2fx",
+                                                   numWorkers, 1000.0 * ms, inlineMs / ms));
+            }
+        }
+
+        beginTest("tracks side by side, shared pool against none");
+        {
+            ChannelWorkerPool pool;
+
+            for( auto numTracks : { 1, 2, 4, 8, 16 } )
+            {
+                juce::OwnedArray<Track> tracks;
+                for( int i = 0; i < numTracks; ++i )
+                    tracks.add(new Track());
+
+                // once without measuring, so the pool's threads are up
+                renderSideBySide(tracks, &pool);
+
+                auto inlineMs = renderSideBySide(tracks, nullptr);
+                auto pooledMs = renderSideBySide(tracks, &pool);
+
+                logMessage(juce::String::formatted("%2d tracks: %.1f ms on their own, %.1f ms with the pool, %.2fx",
+                                                   numTracks, inlineMs, pooledMs, inlineMs / pooledMs));
+            }
+        }
+    }
+};
+
+static WorkerPoolBenchmark workerPoolBenchmark;